@@ -4,11 +4,12 @@
 
 using namespace autowiring;
 
-AutoFilterDescriptorStub::AutoFilterDescriptorStub(auto_id type, autowiring::altitude altitude, const AutoFilterArgument* pArgs, bool deferred, autowiring::t_extractedCall pCall) :
+AutoFilterDescriptorStub::AutoFilterDescriptorStub(auto_id type, autowiring::altitude altitude, const AutoFilterArgument* pArgs, bool deferred, autowiring::t_extractedCall pCall, bool skippable) :
   m_type(type),
   m_altitude(altitude),
   m_pArgs(pArgs),
   m_deferred(deferred),
+  m_skippable(skippable),
   m_pCall(pCall)
 {
   for(auto pArg = m_pArgs; *pArg; pArg++) {
@@ -8,6 +8,7 @@
 #include "Decompose.h"
 #include "has_autofilter.h"
 #include "is_shared_ptr.h"
+#include "skippable.h"
 #include MEMORY_HEADER
 
 namespace autowiring {
@@ -25,12 +26,13 @@ struct AutoFilterDescriptorStub {
   /// <param name="pArgs">The inputs accepted by the filter</param>
   /// <param name="deferred">True if the filter is deferred</param>
   /// <param name="pCall">A pointer to the AutoFilter call routine itself</param>
+  /// <param name="skippable">True if the filter may be skipped on packets past their deadline</param>
   /// <remarks>
   /// The caller is responsible for decomposing the desired routine into the target AutoFilter call.  The extractor
   /// is required to carry information about the type of the proper member function to be called; t_extractedCall is
   /// required to be instantiated by the caller and point to the AutoFilter proxy routine.
   /// </summary>
-  AutoFilterDescriptorStub(auto_id type, autowiring::altitude altitude, const AutoFilterArgument* pArgs, bool deferred, autowiring::t_extractedCall pCall);
+  AutoFilterDescriptorStub(auto_id type, autowiring::altitude altitude, const AutoFilterArgument* pArgs, bool deferred, autowiring::t_extractedCall pCall, bool skippable = false);
 
 protected:
   // Type of the subscriber itself
@@ -49,6 +51,9 @@ protected:
   // decorations.
   bool m_deferred = false;
 
+  // Set if this filter may be skipped on packets which are past their deadline
+  bool m_skippable = false;
+
   // The number of parameters that will be extracted from the repository object when making
   // a Call.  This is used to prime the AutoPacket in order to make saturation checking work
   // correctly.
@@ -71,6 +76,7 @@ public:
   size_t GetRequiredCount(void) const { return m_requiredCount; }
   const AutoFilterArgument* GetAutoFilterArguments(void) const { return m_pArgs; }
   bool IsDeferred(void) const { return m_deferred; }
+  bool IsSkippable(void) const { return m_skippable; }
   auto_id GetAutoFilterTypeInfo(void) const { return m_type; }
 
   /// <returns>
@@ -138,7 +144,8 @@ struct AutoFilterDescriptor:
       >::value,
       Decompose<decltype(&T::AutoFilter)>::template Enumerate<AutoFilterArgument, AutoFilterArgumentT>::types,
       autowiring::CE<decltype(&T::AutoFilter)>::deferred,
-      &autowiring::CE<decltype(&T::AutoFilter)>::template Call<&T::AutoFilter>
+      &autowiring::CE<decltype(&T::AutoFilter)>::template Call<&T::AutoFilter>,
+      autowiring::skippable_of<T>::value
     )
   {
     // T must be a complete type at this point because we are trying to pull out an AutoFilter from it
@@ -184,8 +191,8 @@ struct AutoFilterDescriptor:
   ///
   /// The caller is responsible for decomposing the desired routine into the target AutoFilter call
   /// </summary>
-  AutoFilterDescriptor(const AnySharedPointer& autoFilter, auto_id type, autowiring::altitude altitude, const AutoFilterArgument* pArgs, bool deferred, autowiring::t_extractedCall pCall) :
-    AutoFilterDescriptorStub(type, altitude, pArgs, deferred, pCall),
+  AutoFilterDescriptor(const AnySharedPointer& autoFilter, auto_id type, autowiring::altitude altitude, const AutoFilterArgument* pArgs, bool deferred, autowiring::t_extractedCall pCall, bool skippable = false) :
+    AutoFilterDescriptorStub(type, altitude, pArgs, deferred, pCall, skippable),
     m_autoFilter(autoFilter)
   {}
 
@@ -0,0 +1,57 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "auto_id.h"
+#include "duration_histogram.h"
+#include <atomic>
+#include CHRONO_HEADER
+#include <cstdint>
+
+namespace autowiring {
+
+/// <summary>
+/// Execution statistics gathered for a single AutoFilter by its AutoPacketFactory
+/// </summary>
+/// <remarks>
+/// Run times are inclusive: if a filter decorates a packet and thereby causes another filter to be
+/// called synchronously, the time taken by that downstream call is also included.  For deferred
+/// filters, the run time is the time taken to pend the call to the filter's dispatch queue.
+/// </remarks>
+struct AutoFilterProfile {
+  AutoFilterProfile(auto_id type) :
+    type(type)
+  {}
+
+  // The type of the filter being profiled
+  const auto_id type;
+
+  // Time spent inside of each call to the filter
+  duration_histogram runTime;
+
+  // Time between packet initialization and the moment the filter was called, this is the time the
+  // filter spent waiting for its inputs to become available
+  duration_histogram waitTime;
+
+  // Total time, in nanoseconds, spent by the filter blocked on the lock of a packet
+  std::atomic<uint64_t> lockWait{0};
+};
+
+/// <summary>
+/// A point-in-time copy of an AutoFilterProfile
+/// </summary>
+struct AutoFilterProfileSnapshot {
+  auto_id type;
+  uint64_t calls;
+  duration_histogram::snapshot runTime;
+  duration_histogram::snapshot waitTime;
+  std::chrono::nanoseconds lockWait;
+};
+
+/// <summary>
+/// The number of times a skippable AutoFilter was skipped because its packet was past its deadline
+/// </summary>
+struct AutoFilterSkipCount {
+  auto_id type;
+  uint64_t skips;
+};
+
+}
@@ -5,9 +5,11 @@
 #include "AutoPacketFactory.h"
 #include "AutoPacketInternal.hpp"
 #include "AutoFilterDescriptor.h"
+#include "AutoFilterProfile.h"
 #include "autowiring_error.h"
 #include "ContextEnumerator.h"
 #include "demangle.h"
+#include "FilterGraph.h"
 #include "SatCounter.h"
 #include "thread_specific_ptr.h"
 #include <algorithm>
@@ -16,25 +18,60 @@
 
 using namespace autowiring;
 
+#ifdef AUTOWIRING_USE_THREAD_LOCAL
+// Neither of these pointers owns its referent, so nothing needs to be cleaned up when a thread exits
+// and native thread-local storage is sufficient.
+
+/// <summary>
+/// A pointer to the current AutoPacket, specific to the current thread.
+/// </summary>
+static thread_local AutoPacket* autoCurrentPacket = nullptr;
+
+/// <summary>
+/// The profile of the AutoFilter being run on the current thread, if that filter is being profiled
+/// </summary>
+static thread_local AutoFilterProfile* autoCurrentProfile = nullptr;
+
+static AutoPacket* GetCurrentPacket(void) { return autoCurrentPacket; }
+static void SetCurrentPacket(AutoPacket* apkt) { autoCurrentPacket = apkt; }
+static AutoFilterProfile* GetCurrentProfile(void) { return autoCurrentProfile; }
+static void SetCurrentProfile(AutoFilterProfile* profile) { autoCurrentProfile = profile; }
+#else
 /// <summary>
 /// A pointer to the current AutoPacket, specific to the current thread.
 /// </summary>
 static thread_specific_ptr<AutoPacket> autoCurrentPacket([] (void*) {});
 
+/// <summary>
+/// The profile of the AutoFilter being run on the current thread, if that filter is being profiled
+/// </summary>
+static thread_specific_ptr<AutoFilterProfile> autoCurrentProfile([] (void*) {});
+
+static AutoPacket* GetCurrentPacket(void) { return autoCurrentPacket.get(); }
+static void SetCurrentPacket(AutoPacket* apkt) { autoCurrentPacket.reset(apkt); }
+static AutoFilterProfile* GetCurrentProfile(void) { return autoCurrentProfile.get(); }
+static void SetCurrentProfile(AutoFilterProfile* profile) { autoCurrentProfile.reset(profile); }
+#endif
+
 AutoPacket::AutoPacket(AutoPacketFactory& factory, std::shared_ptr<void>&& outstanding):
   m_parentFactory(std::static_pointer_cast<AutoPacketFactory>(factory.shared_from_this())),
-  m_outstanding(std::move(outstanding))
+  m_outstanding(std::move(outstanding)),
+  m_arena(new DecorationArena)
 {
   // Need to ensure our identity type is instantiated
   (void) auto_id_t_init<AutoPacket>::init;
 }
 
 AutoPacket::~AutoPacket(void) {
-  m_parentFactory->RecordPacketDuration(
-    std::chrono::duration_cast<std::chrono::nanoseconds>(
-      std::chrono::high_resolution_clock::now() - m_initTime
-    )
-  );
+  // Successors which were constructed but never issued have no lifetime to speak of
+  if (m_initTime != std::chrono::high_resolution_clock::time_point()) {
+    m_parentFactory->RecordPacketDuration(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now() - m_initTime
+      )
+    );
+    m_parentFactory->PacketReleased(m_shed);
+  }
 
   // Mark decorations of successor packets that use decorations
   // originating from this packet as unsatisfiable
@@ -65,6 +102,9 @@ AutoPacket::~AutoPacket(void) {
     delete cur;
     cur = next;
   }
+
+  // Decorations still held elsewhere will keep the arena alive until they are released
+  m_arena->Release();
 }
 
 DecorationDisposition& AutoPacket::DecorateImmediateUnsafe(const DecorationKey& key, const void* pvImmed)
@@ -82,6 +122,7 @@ DecorationDisposition& AutoPacket::DecorateImmediateUnsafe(const DecorationKey&
   // Mark the entry as appropriate:
   dec.m_state = DispositionState::Complete;
   dec.m_pImmediate = pvImmed;
+  Trace(AutoPacketTraceEvent::Kind::Decorate, key.id);
   return dec;
 }
 
@@ -90,9 +131,9 @@ void AutoPacket::AddSatCounterUnsafe(SatCounter& satCounter) {
     DecorationKey key(pCur->id, pCur->tshift);
     DecorationDisposition& entry = m_decoration_map[key];
 
-    // Make sure decorations exist for timeshifts less that key's timeshift
-    for (int tshift = 0; tshift < key.tshift; ++tshift)
-      m_decoration_map[DecorationKey(key.id, tshift)];
+    // Record the timeshift on the originating entry so that decorations are forwarded to us
+    if (key.tshift)
+      m_decoration_map[DecorationKey(key.id, 0)].m_timeshifts |= 1ULL << key.tshift;
 
     // Decide what to do with this entry:
     if (pCur->is_input) {
@@ -240,30 +281,52 @@ void AutoPacket::RemoveSatCounterUnsafe(const SatCounter& satCounter) {
 
 void AutoPacket::MarkUnsatisfiable(const DecorationKey& key) {
   // Ensure correct type if instantiated here
-  std::unique_lock<std::mutex> lk(m_lock);
+  std::unique_lock<std::mutex> lk = LockProfiled();
   auto& entry = m_decoration_map[key];
 
   // Clear all decorations and pointers attached here
   entry.m_state = DispositionState::Complete;
   entry.m_decorations.clear();
   entry.m_pImmediate = nullptr;
+  Trace(AutoPacketTraceEvent::Kind::Unsatisfiable, key.id);
 
   // Notify all consumers
   UpdateSatisfactionUnsafe(std::move(lk), entry);
 }
 
 void AutoPacket::MarkSuccessorsUnsatisfiable(DecorationKey key) {
-  std::lock_guard<std::mutex> lk(m_lock);
+  ForEachTimeshiftedSuccessor(
+    key,
+    [] (AutoPacket& successor, const DecorationKey& key) {
+      successor.MarkUnsatisfiable(key);
+    }
+  );
+}
 
-  // Update key and successor
-  key.tshift++;
-  auto successor = SuccessorUnsafe();
+template<class Fn>
+void AutoPacket::ForEachTimeshiftedSuccessor(const DecorationKey& key, Fn&& fn) {
+  // Bit N of this mask is set if the successor N packets from now consumes this decoration
+  uint64_t timeshifts;
+  std::shared_ptr<AutoPacket> successor;
+  {
+    std::lock_guard<std::mutex> lk(m_lock);
+    auto q = m_decoration_map.find(DecorationKey(key.id, 0));
+    if (q == m_decoration_map.end())
+      return;
 
-  while (m_decoration_map.count(key)) {
-    successor->MarkUnsatisfiable(key);
+    timeshifts = (q->second.m_timeshifts >> key.tshift) & ~1ULL;
+    if (!timeshifts)
+      // Nobody consumes this decoration on a later packet
+      return;
+    successor = SuccessorUnsafe();
+  }
 
-    // Update key and successor
-    key.tshift++;
+  for (int n = 1;; n++) {
+    timeshifts >>= 1;
+    if (timeshifts & 1)
+      fn(*successor, DecorationKey(key.id, key.tshift + n));
+    if (timeshifts == 1)
+      break;
     successor = successor->Successor();
   }
 }
@@ -307,7 +370,7 @@ void AutoPacket::UpdateSatisfactionUnsafe(std::unique_lock<std::mutex> lk, const
         {
           AutoCurrentPacketPusher apkt(*this);
           for (SatCounter* call : callQueue)
-            call->GetCall()(call->GetAutoFilter().ptr(), *this);
+            InvokeFilter(*call);
         }
         callQueue.clear();
         lk.lock();
@@ -381,7 +444,7 @@ void AutoPacket::UpdateSatisfactionUnsafe(std::unique_lock<std::mutex> lk, const
   {
     AutoCurrentPacketPusher apkt(*this);
     for (SatCounter* call : callQueue)
-      call->GetCall()(call->GetAutoFilter().ptr(), *this);
+      InvokeFilter(*call);
   }
 
   // Mark all unsatisfiable output types
@@ -443,13 +506,124 @@ void AutoPacket::PulseSatisfactionUnsafe(std::unique_lock<std::mutex> lk, Decora
     // Run through calls while unsynchronized:
     lk.unlock();
     for (SatCounter* call : callQueue) {
-      call->GetCall()(call->GetAutoFilter().ptr(), *this);
+      InvokeFilter(*call);
       call->remaining = 0;
     }
     lk.lock();
   } while (!callQueue.empty());
 }
 
+void AutoPacket::InvokeFilter(SatCounter& call) {
+  if (m_shed.load(std::memory_order_relaxed)) {
+    // Factory no longer wants this packet processed, but downstream filters with optional inputs must
+    // still learn that this filter's outputs will never arrive
+    MarkOutputsUnsatisfiable(call);
+    return;
+  }
+
+  if (call.IsSkippable() && IsPastDeadline()) {
+    SkipFilter(call);
+    return;
+  }
+
+  AutoFilterProfile* profile = call.profile.get();
+  AutoPacketTracer* tracer = m_tracer.load(std::memory_order_acquire);
+  if (!profile && !tracer) {
+    call.GetCall()(call.GetAutoFilter().ptr(), *this);
+    return;
+  }
+
+  if (tracer)
+    tracer->Record(AutoPacketTraceEvent::Kind::FilterBegin, m_traceId, call.GetType());
+
+  // Lock waits incurred by this filter are attributed to it until it returns
+  std::chrono::high_resolution_clock::time_point start;
+  AutoFilterProfile* prior = nullptr;
+  if (profile) {
+    start = std::chrono::high_resolution_clock::now();
+    profile->waitTime.record(start - m_initTime);
+    prior = GetCurrentProfile();
+    SetCurrentProfile(profile);
+  }
+
+  auto x = MakeAtExit([&] {
+    if (profile) {
+      profile->runTime.record(std::chrono::high_resolution_clock::now() - start);
+      SetCurrentProfile(prior);
+    }
+    if (tracer)
+      tracer->Record(AutoPacketTraceEvent::Kind::FilterEnd, m_traceId, call.GetType());
+  });
+  call.GetCall()(call.GetAutoFilter().ptr(), *this);
+}
+
+void AutoPacket::SkipFilter(SatCounter& call) {
+  m_parentFactory->RecordSkippedFilter(call);
+  MarkOutputsUnsatisfiable(call);
+}
+
+void AutoPacket::MarkOutputsUnsatisfiable(SatCounter& call) {
+  // Each output counts as a completed producer run that attached nothing, exactly as though the filter
+  // had run and declined to commit.  Consumers of these outputs are cascaded just like any other
+  // unsatisfiable decoration, and outputs which have other producers are still awaited.
+  const auto* args = call.GetAutoFilterArguments();
+  for (size_t i = call.GetArity(); i--;) {
+    if (!args[i].is_output)
+      continue;
+
+    std::unique_lock<std::mutex> lk(m_lock);
+    auto& disposition = m_decoration_map[DecorationKey{args[i].id, 0}];
+    Trace(AutoPacketTraceEvent::Kind::Unsatisfiable, args[i].id);
+    if (disposition.IncProducerCount())
+      UpdateSatisfactionUnsafe(std::move(lk), disposition);
+  }
+}
+
+uint64_t AutoPacket::GetFilterGraphVersion(void) const {
+  return m_filterGraph ? m_filterGraph->version : 0;
+}
+
+bool AutoPacket::SkipIfPastDeadline(const void* pObj, void(*pCall)(const void*, AutoPacket&)) {
+  if (!IsPastDeadline())
+    return false;
+
+  SatCounter* call = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(m_lock);
+    for (auto* sat = m_firstCounter; sat; sat = sat->flink)
+      if (sat->GetAutoFilter().ptr() == pObj && sat->GetCall() == pCall) {
+        call = sat;
+        break;
+      }
+  }
+  if (!call || !call->IsSkippable())
+    return false;
+
+  SkipFilter(*call);
+  return true;
+}
+
+std::unique_lock<std::mutex> AutoPacket::LockProfiled(void) const {
+  std::unique_lock<std::mutex> lk(m_lock, std::try_to_lock);
+  if (lk.owns_lock())
+    // Uncontended, nothing to record
+    return lk;
+
+  AutoFilterProfile* profile = GetCurrentProfile();
+  if (!profile) {
+    lk.lock();
+    return lk;
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  lk.lock();
+  profile->lockWait.fetch_add(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count(),
+    std::memory_order_relaxed
+  );
+  return lk;
+}
+
 bool AutoPacket::HasUnsafe(const DecorationKey& key) const {
   auto q = m_decoration_map.find(key);
   if(q == m_decoration_map.end())
@@ -459,7 +633,7 @@ bool AutoPacket::HasUnsafe(const DecorationKey& key) const {
 
 void AutoPacket::DecorateNoPriors(const AnySharedPointer& ptr, DecorationKey key) {
   DecorationDisposition* disposition;
-  std::unique_lock<std::mutex> lk(m_lock);
+  std::unique_lock<std::mutex> lk = LockProfiled();
 
   disposition = &m_decoration_map[key];
   switch (disposition->m_state) {
@@ -483,25 +657,25 @@ void AutoPacket::DecorateNoPriors(const AnySharedPointer& ptr, DecorationKey key
   // Decoration attaches here, if it is non-null
   if(ptr)
     disposition->m_decorations.push_back(ptr);
+  Trace(
+    ptr ? AutoPacketTraceEvent::Kind::Decorate : AutoPacketTraceEvent::Kind::Unsatisfiable,
+    key.id
+  );
   if(disposition->IncProducerCount())
     UpdateSatisfactionUnsafe(std::move(lk), *disposition);
 }
 
 void AutoPacket::Decorate(const AnySharedPointer& ptr, DecorationKey key) {
-  auto cur = shared_from_this();
-
-  do {
-    // Update satisfaction set on this entry
-    cur->DecorateNoPriors(ptr, key);
-
-    // Obtain the successor
-    cur = cur->Successor();
-    key.tshift++;
-  } while (
-    // If there are any filters on _this_ packet that desire to know the prior packet, then
-    // we must proactively preserve the value of this decoration for our successor.
-    (std::lock_guard<std::mutex>)m_lock,
-    m_decoration_map.count(key)
+  // Update satisfaction set on this entry
+  DecorateNoPriors(ptr, key);
+
+  // If there are any filters that desire to know the prior packet, then we must proactively
+  // preserve the value of this decoration for the successors that will consume it.
+  ForEachTimeshiftedSuccessor(
+    key,
+    [&ptr] (AutoPacket& successor, const DecorationKey& key) {
+      successor.DecorateNoPriors(ptr, key);
+    }
   );
 }
 
@@ -515,7 +689,7 @@ void AutoPacket::RemoveDecoration(DecorationKey key) {
 }
 
 const DecorationDisposition* AutoPacket::GetDisposition(const DecorationKey& key) const {
-  std::lock_guard<std::mutex> lk(m_lock);
+  auto lk = LockProfiled();
 
   auto q = m_decoration_map.find(key);
   if (q != m_decoration_map.end() && q->second.m_state == DispositionState::Complete)
@@ -524,6 +698,19 @@ const DecorationDisposition* AutoPacket::GetDisposition(const DecorationKey& key
   return nullptr;
 }
 
+void AutoPacket::GetDispositions(const DecorationKey* keys, const DecorationDisposition** out, size_t n) const {
+  auto lk = LockProfiled();
+  for (size_t i = 0; i < n; i++) {
+    out[i] = nullptr;
+    if (keys[i].tshift < 0)
+      continue;
+
+    auto q = m_decoration_map.find(keys[i]);
+    if (q != m_decoration_map.end() && q->second.m_state == DispositionState::Complete)
+      out[i] = &q->second;
+  }
+}
+
 bool AutoPacket::HasSubscribers(const DecorationKey& key) const {
   std::lock_guard<std::mutex> lk(m_lock);
   auto q = m_decoration_map.find(key);
@@ -630,7 +817,7 @@ const SatCounter* AutoPacket::AddRecipient(const AutoFilterDescriptor& descripto
 
   if (!sat.remaining)
     // Filter is ready to be called, oblige it
-    sat.GetCall()(sat.GetAutoFilter().ptr(), *this);
+    InvokeFilter(sat);
 
   return &sat;
 }
@@ -655,22 +842,20 @@ std::shared_ptr<AutoPacket> AutoPacket::SuccessorUnsafe(void) {
   // If successor doesn't already exists, create it
   if (!m_successor){
     m_successor = m_parentFactory->ConstructPacket();
+    Trace(AutoPacketTraceEvent::Kind::Successor);
   }
 
   return m_successor;
 }
 
 AutoPacket* AutoPacket::SetCurrent(AutoPacket* apkt) {
-  AutoPacket* prior = autoCurrentPacket.get();
-  if(apkt)
-    autoCurrentPacket.reset(apkt);
-  else
-    autoCurrentPacket.release();
+  AutoPacket* prior = GetCurrentPacket();
+  SetCurrentPacket(apkt);
   return prior;
 }
 
 AutoPacket& AutoPacket::CurrentPacket(void) {
-  auto retVal = autoCurrentPacket.get();
+  auto retVal = GetCurrentPacket();
   if (!retVal)
     throw autowiring_error("Attempted to obtain a current AutoPacket, which was not made");
 
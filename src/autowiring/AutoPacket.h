@@ -6,7 +6,9 @@
 #include "auto_id.h"
 #include "auto_tuple.h"
 #include "AutoFilterArgument.h"
+#include "AutoPacketTracer.h"
 #include "Decompose.h"
+#include "DecorationArena.h"
 #include "DecorationDisposition.h"
 #include "is_any.h"
 #include "index_tuple.h"
@@ -32,9 +34,13 @@ namespace autowiring {
   struct choice;
 
   struct AutoFilterDescriptor;
+  struct FilterGraph;
 
   template<class T>
   class auto_arg;
+
+  template<size_t N>
+  class DispositionCache;
 }
 
 /// <summary>
@@ -76,13 +82,48 @@ protected:
   // Outstanding count local and remote holds:
   const std::shared_ptr<void> m_outstanding;
 
+  // The version of the factory's filter graph in effect when this packet was issued
+  std::shared_ptr<const autowiring::FilterGraph> m_filterGraph;
+
   // Pointer to a forward linked list of saturation counters, constructed when the packet is created
   autowiring::SatCounter* m_firstCounter = nullptr;
 
+  // Storage for decorations constructed by this packet.  Released when the packet is destroyed, but
+  // kept alive until the last decoration allocated from it has also been destroyed.
+  autowiring::DecorationArena* const m_arena;
+
   t_decorationMap m_decoration_map;
 
   mutable std::mutex m_lock;
 
+  // Set when the factory has shed this packet to admit a newer one
+  std::atomic<bool> m_shed{false};
+
+  // The time, in ticks of the steady clock, after which skippable filters are no longer called on
+  // this packet.  Holds the maximum representable value if the packet has no deadline.
+  std::atomic<std::chrono::steady_clock::rep> m_deadline{(std::chrono::steady_clock::time_point::max)().time_since_epoch().count()};
+
+  // Instrumentation types which observe the packet's internal state
+  friend class AutoPacketGraph;
+  friend class AutoPacketTracer;
+
+  // Resolves all of the inputs of a single AutoFilter call at once
+  template<size_t N>
+  friend class autowiring::DispositionCache;
+
+  // The tracer recording events on this packet, if this packet was sampled for tracing, and the
+  // identifier the tracer assigned to this packet
+  std::atomic<AutoPacketTracer*> m_tracer{nullptr};
+  uint64_t m_traceId = 0;
+
+  /// <summary>
+  /// Records a trace event on this packet, if this packet is being traced
+  /// </summary>
+  void Trace(AutoPacketTraceEvent::Kind kind, auto_id type = auto_id{}) const {
+    if (AutoPacketTracer* tracer = m_tracer.load(std::memory_order_acquire))
+      tracer->Record(kind, m_traceId, type);
+  }
+
   /// <summary>
   /// Checks out the decoration named by the specified type information and attaches the specified immediate pointer to it
   /// </summary>
@@ -116,6 +157,16 @@ protected:
   /// </summary>
   void MarkSuccessorsUnsatisfiable(autowiring::DecorationKey type);
 
+  /// <summary>
+  /// Invokes fn(successor, key) for each successor packet which consumes the decoration at key
+  /// </summary>
+  /// <remarks>
+  /// Only successors at timeshifts recorded in the consuming filters' arguments are visited, the
+  /// remaining packets in the successor chain are skipped over.
+  /// </remarks>
+  template<class Fn>
+  void ForEachTimeshiftedSuccessor(const autowiring::DecorationKey& key, Fn&& fn);
+
   /// <summary>
   /// Updates subscriber statuses given that the specified type information has been satisfied
   /// </summary>
@@ -136,6 +187,30 @@ protected:
   /// </remarks>
   void PulseSatisfactionUnsafe(std::unique_lock<std::mutex> lk, autowiring::DecorationDisposition* pTypeSubs [], size_t nInfos);
 
+  /// <summary>
+  /// Calls the AutoFilter described by the specified counter, recording its profile if it has one
+  /// </summary>
+  void InvokeFilter(autowiring::SatCounter& call);
+
+  /// <summary>
+  /// Skips the filter described by the specified counter, marking all of its outputs unsatisfiable
+  /// </summary>
+  /// <remarks>
+  /// Used in place of InvokeFilter for skippable filters once the packet is past its deadline
+  /// </remarks>
+  void SkipFilter(autowiring::SatCounter& call);
+
+  /// <summary>
+  /// Marks all outputs of the filter described by the specified counter unsatisfiable, as though the
+  /// filter had run and attached nothing
+  /// </summary>
+  void MarkOutputsUnsatisfiable(autowiring::SatCounter& call);
+
+  /// <summary>
+  /// Acquires m_lock, attributing any time spent blocked to the filter running on this thread
+  /// </summary>
+  std::unique_lock<std::mutex> LockProfiled(void) const;
+
   /// <summary>Unsynchronized runtime counterpart to Has</summary>
   bool HasUnsafe(const autowiring::DecorationKey& key) const;
 
@@ -161,6 +236,74 @@ protected:
   /// <returns>The disposition, if the decoration exists and is satisfied, otherwise nullptr</returns>
   const autowiring::DecorationDisposition* GetDisposition(const autowiring::DecorationKey& ti) const;
 
+  /// <summary>
+  /// Retrieves the decoration dispositions for several keys under a single lock acquisition
+  /// </summary>
+  /// <remarks>
+  /// Each entry of out receives the value GetDisposition would return for the corresponding key.
+  /// Keys with a negative time shift are not looked up, and their entries are set to nullptr.
+  /// </remarks>
+  void GetDispositions(const autowiring::DecorationKey* keys, const autowiring::DecorationDisposition** out, size_t n) const;
+
+  /// <summary>
+  /// Obtains a pointer to the single decoration held by the specified disposition
+  /// </summary>
+  /// <param name="pDisposition">The disposition of key, as returned by GetDisposition</param>
+  /// <returns>True if a decoration was found</returns>
+  /// <remarks>
+  /// Throws an exception if the decoration is multiply present on the packet
+  /// </remarks>
+  template<class T>
+  static bool GetFrom(const autowiring::DecorationDisposition* pDisposition, const autowiring::DecorationKey& key, const T*& out) {
+    if (pDisposition) {
+      switch (pDisposition->m_decorations.size()) {
+      case 0:
+        // No shared pointer decorations available, we have to try something else
+        break;
+      case 1:
+        // Single decoration, we can do what the user is asking
+        out = static_cast<const T*>(pDisposition->m_decorations[0].ptr());
+        return true;
+      default:
+        ThrowMultiplyDecoratedException(key);
+        break;
+      }
+
+      // Second-chance satisfaction with an immediate
+      if (pDisposition->m_pImmediate) {
+        out = (T*) pDisposition->m_pImmediate;
+        return true;
+      }
+    }
+
+    out = nullptr;
+    return false;
+  }
+
+  /// <summary>
+  /// Shared pointer counterpart of GetFrom, immediate decorations are not considered
+  /// </summary>
+  template<class T>
+  static bool GetFrom(const autowiring::DecorationDisposition* pDisposition, const autowiring::DecorationKey& key, const std::shared_ptr<T>*& out) {
+    if (!pDisposition) {
+      out = nullptr;
+      return false;
+    }
+    switch (pDisposition->m_decorations.size()) {
+    case 0:
+      // Simple non-availability, trivial return
+      out = nullptr;
+      return false;
+    case 1:
+      // Single decoration available, we can return here
+      out = &pDisposition->m_decorations[0].as<T>();
+      return true;
+    default:
+      ThrowMultiplyDecoratedException(key);
+      return false;
+    }
+  }
+
   /// <returns>True if the indicated type has been requested for use by some consumer</returns>
   bool HasSubscribers(const autowiring::DecorationKey& key) const;
 
@@ -184,6 +327,52 @@ protected:
   static void ThrowMultiplyDecoratedException(const autowiring::DecorationKey& key);
 
 public:
+  /// <returns>
+  /// True if the factory shed this packet under its drop-oldest admission policy
+  /// </returns>
+  /// <remarks>
+  /// No further filters are called on a shed packet.  Filters that are already running may check this
+  /// flag to abandon their work early.
+  /// </remarks>
+  bool IsShed(void) const { return m_shed; }
+
+  /// <returns>
+  /// The version of the factory's filter graph that this packet was issued with, or 0 if no filters
+  /// were registered at the time
+  /// </returns>
+  uint64_t GetFilterGraphVersion(void) const;
+
+  /// <returns>The deadline of this packet, or time_point::max() if the packet has no deadline</returns>
+  std::chrono::steady_clock::time_point GetDeadline(void) const {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_deadline.load(std::memory_order_relaxed)));
+  }
+
+  /// <returns>True if this packet was issued with a deadline</returns>
+  bool HasDeadline(void) const {
+    return GetDeadline() != (std::chrono::steady_clock::time_point::max)();
+  }
+
+  /// <returns>True if this packet has a deadline, and that deadline has passed</returns>
+  /// <remarks>
+  /// Long-running filters may check this to abandon their work early
+  /// </remarks>
+  bool IsPastDeadline(void) const {
+    return HasDeadline() && std::chrono::steady_clock::now() > GetDeadline();
+  }
+
+  /// <summary>
+  /// Skips a deferred filter on this packet if the filter is skippable and the packet is past its deadline
+  /// </summary>
+  /// <param name="pObj">The filter instance, as passed to the filter's call routine</param>
+  /// <param name="pCall">The call routine of the filter</param>
+  /// <returns>True if the filter was skipped and must not be called</returns>
+  /// <remarks>
+  /// Deferred filters are dispatched when they are satisfied but may run much later.  This method is
+  /// called when the dispatched call is about to run, so that a deadline which passed while the call
+  /// was pending is still honored.
+  /// </remarks>
+  bool SkipIfPastDeadline(const void* pObj, void(*pCall)(const void*, AutoPacket&));
+
   /// <returns>
   /// The number of distinct decoration types on this packet (this is really an implementation-detail-based count
   /// of the parameters of all relevant filters, including lambdas appended to this packet).
@@ -245,30 +434,7 @@ public:
   template<class T>
   bool Get(const T*& out, int tshift=0) const {
     autowiring::DecorationKey key(auto_id_t<T>{}, tshift);
-    const autowiring::DecorationDisposition* pDisposition = GetDisposition(key);
-    if (pDisposition) {
-      switch (pDisposition->m_decorations.size()) {
-      case 0:
-        // No shared pointer decorations available, we have to try something else
-        break;
-      case 1:
-        // Single decoration, we can do what the user is asking
-        out = static_cast<const T*>(pDisposition->m_decorations[0].ptr());
-        return true;
-      default:
-        ThrowMultiplyDecoratedException(key);
-        break;
-      }
-
-      // Second-chance satisfaction with an immediate
-      if (pDisposition->m_pImmediate) {
-        out = (T*) pDisposition->m_pImmediate;
-        return true;
-      }
-    }
-
-    out = nullptr;
-    return false;
+    return GetFrom(GetDisposition(key), key, out);
   }
 
   /// <summary>
@@ -289,24 +455,7 @@ public:
 
     // Decoration must be present and the shared pointer itself must also be present
     autowiring::DecorationKey key(auto_id_t<TActual>{}, tshift);
-    const autowiring::DecorationDisposition* pDisposition = GetDisposition(key);
-    if (!pDisposition) {
-      out = nullptr;
-      return false;
-    }
-    switch (pDisposition->m_decorations.size()) {
-    case 0:
-      // Simple non-availability, trivial return
-      out = nullptr;
-      return false;
-    case 1:
-      // Single decoration available, we can return here
-      out = &pDisposition->m_decorations[0].as<T>();
-      return true;
-    default:
-      ThrowMultiplyDecoratedException(key);
-      return false;
-    }
+    return GetFrom(GetDisposition(key), key, out);
   }
 
   /// <summary>
@@ -509,8 +658,8 @@ public:
     static_assert(!std::is_pointer<T>::value, "Can't decorate using a pointer type.");
     typedef typename std::decay<T>::type TActual;
 
-    // Create a copy of the input, put the copy in a shared pointer
-    auto ptr = std::make_shared<TActual>(std::forward<T&&>(t));
+    // Create a copy of the input, put the copy in a shared pointer allocated from our arena
+    auto ptr = std::allocate_shared<TActual>(m_arena->get_allocator<TActual>(), std::forward<T&&>(t));
     Decorate(
       AnySharedPointer(ptr),
       autowiring::DecorationKey(auto_id_t<TActual>{}, 0)
@@ -529,8 +678,8 @@ public:
   template<class T, typename... Args>
   const T& Emplace(Args&&... args) {
     static_assert(!std::is_pointer<T>::value, "Can't decorate using a pointer type.");
-    // Create a copy of the input, put the copy in a shared pointer
-    auto ptr = std::make_shared<T>(std::forward<Args&&>(args)...);
+    // Construct in place, in a shared pointer allocated from our arena
+    auto ptr = std::allocate_shared<T>(m_arena->get_allocator<T>(), std::forward<Args&&>(args)...);
     Decorate(
       AnySharedPointer(ptr),
       autowiring::DecorationKey(auto_id_t<T>(), 0)
@@ -3,13 +3,16 @@
 #include "AutoPacketFactory.h"
 #include "AutoPacketInternal.hpp"
 #include "CoreContext.h"
+#include "demangle.h"
 #include "SatCounter.h"
 #include <cmath>
+#include <ostream>
 
 using namespace autowiring;
 
 AutoPacketFactory::AutoPacketFactory(void):
-  ContextMember("AutoPacketFactory")
+  ContextMember("AutoPacketFactory"),
+  m_statisticsEpoch(std::chrono::steady_clock::now().time_since_epoch().count())
 {}
 
 AutoPacketFactory::~AutoPacketFactory() {}
@@ -26,30 +29,178 @@ std::shared_ptr<AutoPacket> AutoPacketFactory::CurrentPacket(void) {
 }
 
 std::shared_ptr<AutoPacket> AutoPacketFactory::NewPacket(void) {
+  return IssuePacket(true);
+}
+
+std::shared_ptr<AutoPacket> AutoPacketFactory::NewPacket(std::chrono::steady_clock::time_point deadline) {
+  return IssuePacket(true, deadline);
+}
+
+std::shared_ptr<AutoPacket> AutoPacketFactory::NewPacket(std::chrono::nanoseconds budget) {
+  return IssuePacket(true, std::chrono::steady_clock::now() + budget);
+}
+
+std::shared_ptr<AutoPacket> AutoPacketFactory::TryNewPacket(void) {
+  return IssuePacket(false);
+}
+
+std::shared_ptr<AutoPacket> AutoPacketFactory::IssueUnsequenced(std::chrono::steady_clock::time_point deadline) {
+  auto graph = GetFilterGraph();
+  if (graph && graph->timeshifted)
+    // Filters rely on the successor chain
+    return nullptr;
+
+  if (ShouldStop())
+    // Let the sequenced path report the error
+    return nullptr;
+
+  // While the factory is running, the next packet holds the internal outstanding counter and so it is
+  // never reassigned, which makes it safe to lock here without holding m_lock
+  std::shared_ptr<void> outstanding = m_outstandingInternal.lock();
+  if (!outstanding)
+    return nullptr;
+
+  ++m_nOutstanding;
+  auto retVal = std::make_shared<AutoPacketInternal>(*this, std::move(outstanding));
+
+  // There are no timeshifted filters, so there is no need to know whether this is the first packet
+  retVal->Initialize(false, std::move(graph), deadline);
+  return retVal;
+}
+
+std::shared_ptr<AutoPacket> AutoPacketFactory::IssuePacket(bool wait, std::chrono::steady_clock::time_point deadline) {
+  if (m_unsequenced.load(std::memory_order_relaxed) && !m_maxOutstanding.load(std::memory_order_relaxed))
+    if (auto retVal = IssueUnsequenced(deadline))
+      return retVal;
+
   std::shared_ptr<AutoPacketInternal> retVal;
   bool isFirstPacket;
   {
-    std::lock_guard<std::mutex> lk(m_lock);
+    std::unique_lock<std::mutex> lk(m_lock);
 
     if (ShouldStop())
       throw autowiring_error("Attempted to create a packet on an AutoPacketFactory that was already terminated");
     if (!IsRunning())
       throw autowiring_error("Cannot create a packet until the AutoPacketFactory is started");
 
+    while (!HasCapacityUnsafe()) {
+      if (m_admissionPolicy == AdmissionPolicy::DropOldest) {
+        // Shed the oldest packet that is still alive.  It no longer counts against the limit, so the
+        // new packet is issued without waiting for the shed packet to be destroyed.
+        std::shared_ptr<AutoPacketInternal> shed;
+        while (!m_issued.empty() && !shed) {
+          shed = m_issued.front().lock();
+          m_issued.pop_front();
+        }
+        if (shed) {
+          ++m_nDropped;
+          ++m_nShedOutstanding;
+
+          lk.unlock();
+          shed->Shed();
+          shed.reset();
+          lk.lock();
+          continue;
+        }
+
+        // Every packet holding capacity was issued before this policy was set, and cannot be shed
+      }
+
+      if (!wait) {
+        ++m_nRejected;
+        return nullptr;
+      }
+
+      ++m_nAdmissionWaiters;
+      m_admissionCv.wait(lk, [this] { return ShouldStop() || HasCapacityUnsafe(); });
+      --m_nAdmissionWaiters;
+      if (ShouldStop())
+        throw autowiring_error("AutoPacketFactory was terminated while waiting for an outstanding packet to be released");
+    }
+
     // New packet issued
-    isFirstPacket = !m_packetCount;
-    ++m_packetCount;
+    isFirstPacket = !m_issuedCount;
+    ++m_issuedCount;
+    ++m_nOutstanding;
 
     // Create a new next packet
     retVal = m_nextPacket;
     m_nextPacket = retVal->SuccessorInternal();
     m_curPacket = retVal;
+
+    if (m_admissionPolicy == AdmissionPolicy::DropOldest) {
+      // Packets usually complete in order, trimming from the front keeps this collection short
+      while (!m_issued.empty() && m_issued.front().expired())
+        m_issued.pop_front();
+      m_issued.push_back(retVal);
+    }
   }
 
-  retVal->Initialize(isFirstPacket);
+  retVal->Initialize(isFirstPacket, GetFilterGraph(), deadline);
+  return retVal;
+}
+
+bool AutoPacketFactory::HasCapacityUnsafe(void) const {
+  if (m_admissionPolicy == AdmissionPolicy::Unbounded || !m_maxOutstanding)
+    return true;
+
+  // Shed packets are only decremented outside of the lock, and are only incremented under it, so
+  // reading the outstanding count first can never yield fewer outstanding than shed packets
+  size_t nOutstanding = m_nOutstanding;
+  if (m_admissionPolicy == AdmissionPolicy::DropOldest)
+    nOutstanding -= m_nShedOutstanding;
+  return nOutstanding < m_maxOutstanding;
+}
+
+void AutoPacketFactory::PacketReleased(bool shed) {
+  if (shed)
+    --m_nShedOutstanding;
+  --m_nOutstanding;
+
+  // Only synchronize if someone might be waiting for this packet
+  if (m_nAdmissionWaiters)
+    std::lock_guard<std::mutex>{m_lock},
+    m_admissionCv.notify_all();
+}
+
+void AutoPacketFactory::RecordSkippedFilter(const SatCounter& satCounter) {
+  // Skips happen when the system is overloaded, so they must not contend with packet issue
+  if (satCounter.skipCount)
+    satCounter.skipCount->fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<AutoFilterSkipCount> AutoPacketFactory::GetSkippedFilterCounts(void) const {
+  std::vector<AutoFilterSkipCount> retVal;
+  auto graph = GetFilterGraph();
+  if (!graph)
+    return retVal;
+
+  for (size_t i = 0; i < graph->filters.size(); i++) {
+    const auto& skipCount = graph->skipCounts[i];
+    if (!skipCount)
+      continue;
+
+    uint64_t skips = skipCount->load(std::memory_order_relaxed);
+    if (skips)
+      retVal.push_back({graph->filters[i].GetType(), skips});
+  }
   return retVal;
 }
 
+void AutoPacketFactory::SetAdmissionPolicy(AdmissionPolicy policy, size_t maxOutstanding) {
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_admissionPolicy = policy;
+  m_maxOutstanding = policy == AdmissionPolicy::Unbounded ? 0 : maxOutstanding;
+  if (policy != AdmissionPolicy::DropOldest)
+    m_issued.clear();
+  m_admissionCv.notify_all();
+}
+
+AdmissionPolicy AutoPacketFactory::GetAdmissionPolicy(void) const {
+  std::lock_guard<std::mutex> lk(m_lock);
+  return m_admissionPolicy;
+}
+
 std::shared_ptr<AutoPacketInternal> AutoPacketFactory::ConstructPacket(void) {
   return std::make_shared<AutoPacketInternal>(*this, GetInternalOutstanding());
 }
@@ -84,26 +235,56 @@ std::shared_ptr<void> AutoPacketFactory::GetInternalOutstanding(void) {
 }
 
 std::vector<AutoFilterDescriptor> AutoPacketFactory::GetAutoFilters(void) const {
-  std::lock_guard<std::mutex> lk(m_lock);
   std::vector<AutoFilterDescriptor> retVal;
-  retVal.assign(m_autoFilters.begin(), m_autoFilters.end());
+  AppendAutoFiltersTo(retVal);
   return retVal;
 }
 
-SatCounter* AutoPacketFactory::CreateSatCounterList(void) const {
-  std::lock_guard<std::mutex> lk(m_lock);
+void AutoPacketFactory::PublishFilterGraphUnsafe(std::shared_ptr<FilterGraph> graph) {
+  auto prior = GetFilterGraph();
+  graph->version = prior ? prior->version + 1 : 1;
+  std::atomic_store(&m_filterGraph, std::shared_ptr<const FilterGraph>(std::move(graph)));
+}
 
+SatCounter* AutoPacketFactory::CreateSatCounterList(const FilterGraph& graph) const {
   // Trivial return check
-  if (m_autoFilters.empty())
+  if (graph.filters.empty())
     return nullptr;
 
-  auto q = m_autoFilters.begin();
+  auto q = graph.filters.begin();
+
+  // Profiles are only attached when requested, so that unprofiled calls remain cheap and lock-free
+  bool profiling = m_profiling;
+  std::unique_lock<std::mutex> lk(m_lock, std::defer_lock);
+
+  // A packet may be built from a graph that has since been superseded.  Filters removed in the
+  // meantime are not profiled, otherwise their profiles would be recreated after being discarded.
+  std::shared_ptr<const FilterGraph> current;
+  if (profiling) {
+    lk.lock();
+    current = GetFilterGraph();
+    if (current.get() == &graph)
+      current.reset();
+  }
+
+  auto attachProfile = [this, profiling, &current] (SatCounter& satCounter) {
+    if (!profiling || (current && !current->contains(satCounter)))
+      return;
+    auto& profile = m_profiles[t_profileKey(satCounter.GetAutoFilter().ptr(), satCounter.GetCall())];
+    if (!profile)
+      profile = std::make_shared<AutoFilterProfile>(satCounter.GetType());
+    satCounter.profile = profile;
+  };
 
   // Construct the linked list.  This code implements a push-front so that retVal
   // always refers to the first element of the linked list.
   SatCounter* retVal = new SatCounter(*q);
-  while (++q != m_autoFilters.end()) {
+  retVal->skipCount = graph.skipCounts.front().get();
+  attachProfile(*retVal);
+  while (++q != graph.filters.end()) {
     SatCounter* next = new SatCounter(*q);
+    next->skipCount = graph.skipCounts[q - graph.filters.begin()].get();
+    attachProfile(*next);
     retVal->blink = next;
     next->flink = retVal;
     retVal = next;
@@ -120,13 +301,15 @@ bool AutoPacketFactory::OnStart(void) {
 
 void AutoPacketFactory::OnStop(bool graceful) {
   // Queue of local variables to be destroyed when leaving scope
-  t_autoFilterSet autoFilters;
+  std::shared_ptr<const FilterGraph> filterGraph;
   std::shared_ptr<AutoPacketInternal> nextPacket;
 
   // Lock destruction precedes local variables
+  std::lock_guard<std::mutex>{m_subscriberLock},
+    filterGraph = std::atomic_exchange(&m_filterGraph, std::shared_ptr<const FilterGraph>());
   std::lock_guard<std::mutex>{m_lock},
-    autoFilters.swap(m_autoFilters),
-    nextPacket.swap(m_nextPacket);
+    nextPacket.swap(m_nextPacket),
+    m_admissionCv.notify_all();
 }
 
 void AutoPacketFactory::DoAdditionalWait(void) {
@@ -156,15 +339,54 @@ void AutoPacketFactory::Clear(void) {
 }
 
 const AutoFilterDescriptor& AutoPacketFactory::AddSubscriber(const AutoFilterDescriptor& rhs) {
-  std::lock_guard<std::mutex> lk(m_lock);
-  m_autoFilters.insert(rhs);
+  std::lock_guard<std::mutex> lk(m_subscriberLock);
+  auto prior = GetFilterGraph();
+  if (prior && prior->contains(rhs))
+    // Already present, nothing to publish
+    return rhs;
+
+  // Copy the prior version, inserting the new filter in order
+  auto graph = std::make_shared<FilterGraph>();
+  if (prior) {
+    graph->filters.reserve(prior->filters.size() + 1);
+    graph->filters = prior->filters;
+    graph->skipCounts = prior->skipCounts;
+    graph->timeshifted = prior->timeshifted;
+  }
+  auto q = std::lower_bound(graph->filters.begin(), graph->filters.end(), rhs);
+  graph->skipCounts.insert(
+    graph->skipCounts.begin() + (q - graph->filters.begin()),
+    rhs.IsSkippable() ? std::make_shared<std::atomic<uint64_t>>(0) : nullptr
+  );
+  graph->filters.insert(q, rhs);
+  graph->timeshifted |= FilterGraph::is_timeshifted(rhs);
+  PublishFilterGraphUnsafe(std::move(graph));
   return rhs;
 }
 
 void AutoPacketFactory::RemoveSubscriber(const AutoFilterDescriptor& autoFilter) {
-  // Trivial removal from the autofilter set:
-  std::lock_guard<std::mutex> lk(m_lock);
-  m_autoFilters.erase(autoFilter);
+  std::lock_guard<std::mutex> lk(m_subscriberLock);
+  auto prior = GetFilterGraph();
+  if (!prior || !prior->contains(autoFilter))
+    return;
+
+  // Copy every other filter from the prior version
+  auto graph = std::make_shared<FilterGraph>();
+  graph->filters.reserve(prior->filters.size() - 1);
+  graph->skipCounts.reserve(prior->filters.size() - 1);
+  for (size_t i = 0; i < prior->filters.size(); i++) {
+    const auto& filter = prior->filters[i];
+    if (!(filter == autoFilter)) {
+      graph->filters.push_back(filter);
+      graph->skipCounts.push_back(prior->skipCounts[i]);
+      graph->timeshifted |= FilterGraph::is_timeshifted(filter);
+    }
+  }
+  PublishFilterGraphUnsafe(std::move(graph));
+
+  // Packets already holding this filter's profile keep it alive until they are destroyed
+  std::lock_guard<std::mutex>{m_lock},
+  m_profiles.erase(t_profileKey(autoFilter.GetAutoFilter().ptr(), autoFilter.GetCall()));
 }
 
 void AutoPacketFactory::operator-=(const AutoFilterDescriptor& desc) {
@@ -173,9 +395,11 @@ void AutoPacketFactory::operator-=(const AutoFilterDescriptor& desc) {
 
 AutoFilterDescriptor AutoPacketFactory::GetTypeDescriptorUnsafe(auto_id nodeType) {
   //ASSUME: type_info uniquely specifies descriptor
-  for (auto& af : m_autoFilters)
+  auto graph = GetFilterGraph();
+  if (graph)
+    for (auto& af : graph->filters)
     if (af.GetAutoFilterTypeInfo() == nodeType)
-      return af;
+        return af;
 
   return AutoFilterDescriptor();
 }
@@ -186,26 +410,85 @@ size_t AutoPacketFactory::GetOutstandingPacketCount(void) const {
 }
 
 void AutoPacketFactory::RecordPacketDuration(std::chrono::nanoseconds duration) {
-  std::unique_lock<std::mutex> lk(m_lock);
-  m_packetDurationSum += duration.count();
-  m_packetDurationSqSum += duration.count() * duration.count();
+  m_packetLifetimes.record(duration);
+}
+
+AutoPacketFactory::PacketStatistics AutoPacketFactory::GetPacketStatistics(bool reset) {
+  auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+  PacketStatistics retVal;
+  auto epoch =
+    reset ?
+    m_statisticsEpoch.exchange(now) :
+    m_statisticsEpoch.load();
+  retVal.lifetime = m_packetLifetimes.take(reset);
+  retVal.window = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::duration(now - epoch));
+  return retVal;
 }
 
 double AutoPacketFactory::GetMeanPacketLifetime(void) {
-  return m_packetDurationSum / m_packetCount;
+  auto lifetime = m_packetLifetimes.take();
+  return lifetime.count ? static_cast<double>(lifetime.sum) / lifetime.count : 0.0;
 }
 
 double AutoPacketFactory::GetPacketLifetimeStandardDeviation(void) {
-  double mean = m_packetDurationSum / m_packetCount;
-  double variance = m_packetDurationSqSum / m_packetCount - mean * mean;
-  return std::sqrt(variance >= 0.0 ? variance : 0.0 );
+  auto lifetime = m_packetLifetimes.take();
+  if (!lifetime.count)
+    return 0.0;
+
+  // Each sample is approximated by the midpoint of its bucket
+  double mean = static_cast<double>(lifetime.sum) / lifetime.count;
+  double sqSum = 0.0;
+  for (size_t i = 0; i + 1 < duration_histogram::BucketCount; i++) {
+    if (!lifetime.counts[i])
+      continue;
+    double midpoint = (duration_histogram::bucket_floor(i) + duration_histogram::bucket_floor(i + 1)) / 2.0;
+    sqSum += lifetime.counts[i] * (midpoint - mean) * (midpoint - mean);
+  }
+  return std::sqrt(sqSum / lifetime.count);
+}
+
+std::chrono::nanoseconds AutoPacketFactory::GetPacketLifetimePercentile(double fraction) {
+  return m_packetLifetimes.take().percentile(fraction);
 }
 
 void AutoPacketFactory::ResetPacketStatistics(void) {
-  std::unique_lock<std::mutex> lk(m_lock);
-  m_packetCount = 0;
-  m_packetDurationSum = 0.0;
-  m_packetDurationSqSum = 0.0;
+  GetPacketStatistics(true);
+}
+
+std::vector<AutoFilterProfileSnapshot> AutoPacketFactory::GetFilterProfiles(bool reset) {
+  std::lock_guard<std::mutex> lk(m_lock);
+  std::vector<AutoFilterProfileSnapshot> retVal;
+  retVal.reserve(m_profiles.size());
+  for (auto& entry : m_profiles) {
+    AutoFilterProfile& profile = *entry.second;
+    retVal.push_back(AutoFilterProfileSnapshot());
+
+    auto& snapshot = retVal.back();
+    snapshot.type = profile.type;
+    snapshot.runTime = profile.runTime.take(reset);
+    snapshot.waitTime = profile.waitTime.take(reset);
+    snapshot.calls = snapshot.runTime.count;
+    snapshot.lockWait = std::chrono::nanoseconds(
+      reset ?
+      profile.lockWait.exchange(0, std::memory_order_relaxed) :
+      profile.lockWait.load(std::memory_order_relaxed)
+    );
+  }
+  return retVal;
+}
+
+void AutoPacketFactory::WriteFilterProfiles(std::ostream& os) {
+  os << "filter,calls,run_p50,run_p99,run_max,wait_p50,wait_p99,wait_max,lock_wait" << std::endl;
+  for (const auto& profile : GetFilterProfiles())
+    os << '"' << autowiring::demangle(profile.type) << "\","
+       << profile.calls << ','
+       << profile.runTime.percentile(0.5).count() << ','
+       << profile.runTime.percentile(0.99).count() << ','
+       << profile.runTime.max << ','
+       << profile.waitTime.percentile(0.5).count() << ','
+       << profile.waitTime.percentile(0.99).count() << ','
+       << profile.waitTime.max << ','
+       << profile.lockWait.count() << std::endl;
 }
 
 template struct autowiring ::SlotInformationStump<AutoPacketFactory, false>;
@@ -2,15 +2,38 @@
 #pragma once
 #include "AutoPacket.h"
 #include "AutoFilterDescriptor.h"
+#include "AutoFilterProfile.h"
 #include "ContextMember.h"
 #include "CoreRunnable.h"
+#include "FilterGraph.h"
 #include "TypeRegistry.h"
 #include CHRONO_HEADER
 #include TYPE_TRAITS_HEADER
-#include <set>
+#include <condition_variable>
+#include <deque>
+#include <iosfwd>
+#include <map>
 
 class AutoPacketInternal;
 
+namespace autowiring {
+  /// <summary>
+  /// Describes what an AutoPacketFactory does when asked for a packet while it is at capacity
+  /// </summary>
+  enum class AdmissionPolicy {
+    // No limit on the number of outstanding packets
+    Unbounded,
+
+    // NewPacket blocks until an outstanding packet is destroyed, TryNewPacket returns nullptr
+    Block,
+
+    // The oldest outstanding packet is shed so that it completes early, and the new packet is issued
+    // at once.  Shed packets no longer count against the limit, so neither NewPacket nor TryNewPacket
+    // waits for them to be destroyed.
+    DropOldest
+  };
+}
+
 /// <summary>
 /// A configurable factory class for pipeline packets with a built-in object pool
 /// </summary>
@@ -39,18 +62,70 @@ private:
   // The next packet to be issued from this factory
   std::shared_ptr<AutoPacketInternal> m_nextPacket;
 
-  // Collection of known subscribers
-  typedef std::set<autowiring::AutoFilterDescriptor> t_autoFilterSet;
-  t_autoFilterSet m_autoFilters;
+  // Serializes changes to the set of subscribers.  This lock is never taken while issuing packets, so
+  // that adding or removing a subscriber cannot delay NewPacket.
+  std::mutex m_subscriberLock;
+
+  // The current version of the set of known subscribers.  Replaced with a new version under
+  // m_subscriberLock whenever the set changes, and read with atomic_load.
+  std::shared_ptr<const autowiring::FilterGraph> m_filterGraph;
+
+  // True if packets may be issued without being linked into the successor chain
+  std::atomic<bool> m_unsequenced{false};
+
+  // True if filters on newly issued packets should be profiled
+  std::atomic<bool> m_profiling{false};
+
+  // Execution profiles for each filter, identified by filter instance and call, guarded by m_lock.  A
+  // profile is discarded when its filter is removed, so that a filter later allocated at the same
+  // address starts with a fresh profile.
+  typedef std::pair<const void*, autowiring::t_extractedCall> t_profileKey;
+  mutable std::map<t_profileKey, std::shared_ptr<autowiring::AutoFilterProfile>> m_profiles;
+
+  // The number of packets issued by this factory
+  uint64_t m_issuedCount = 0;
+
+  // Admission control settings, guarded by m_lock
+  autowiring::AdmissionPolicy m_admissionPolicy = autowiring::AdmissionPolicy::Unbounded;
+  std::atomic<size_t> m_maxOutstanding{0};
 
-  // Accumulators used to compute statistics about AutoPacket lifespan.
-  long long m_packetCount = 0;
-  double m_packetDurationSum = 0.0;
-  double m_packetDurationSqSum = 0.0;
+  // The number of issued packets that have not yet been destroyed, and the number of threads waiting
+  // for this count to decrease.  The waiter count allows packet destruction to skip the lock when
+  // nobody is waiting.
+  std::atomic<size_t> m_nOutstanding{0};
+  std::atomic<size_t> m_nAdmissionWaiters{0};
+
+  // The number of outstanding packets which have already been shed
+  std::atomic<size_t> m_nShedOutstanding{0};
+  std::condition_variable m_admissionCv;
+
+  // Packets issued under the drop-oldest policy, oldest first
+  std::deque<std::weak_ptr<AutoPacketInternal>> m_issued;
+
+  // Number of packets refused by TryNewPacket, and number of packets shed by the drop-oldest policy
+  std::atomic<uint64_t> m_nRejected{0};
+  std::atomic<uint64_t> m_nDropped{0};
+
+  // Lifetimes of packets destroyed since the last statistics reset, and the time of that reset in
+  // ticks of the steady clock
+  autowiring::duration_histogram m_packetLifetimes;
+  std::atomic<std::chrono::steady_clock::rep> m_statisticsEpoch;
 
   // Returns the internal outstanding count, for use with AutoPacket
   std::shared_ptr<void> GetInternalOutstanding(void);
 
+  // Publishes a new version of the filter graph, must be called with m_subscriberLock held
+  void PublishFilterGraphUnsafe(std::shared_ptr<autowiring::FilterGraph> graph);
+
+  // Issues a packet outside of the successor chain, returns nullptr if the packet must be sequenced
+  std::shared_ptr<AutoPacket> IssueUnsequenced(std::chrono::steady_clock::time_point deadline);
+
+  // True if another packet may be issued under the admission policy, must be called with m_lock held
+  bool HasCapacityUnsafe(void) const;
+
+  // Common implementation of NewPacket and TryNewPacket
+  std::shared_ptr<AutoPacket> IssuePacket(bool wait, std::chrono::steady_clock::time_point deadline = (std::chrono::steady_clock::time_point::max)());
+
   // Utility override, does nothing
   void AddSubscriber(std::false_type) {}
 
@@ -60,8 +135,8 @@ public:
   /// </summary>
   template<class T>
   void AppendAutoFiltersTo(T& container) const {
-    std::lock_guard<std::mutex> lk(m_lock);
-    container.insert(container.end(), m_autoFilters.begin(), m_autoFilters.end());
+    if (auto graph = GetFilterGraph())
+      container.insert(container.end(), graph->filters.begin(), graph->filters.end());
   }
 
   /// <returns>
@@ -69,11 +144,22 @@ public:
   /// </returns>
   std::vector<autowiring::AutoFilterDescriptor> GetAutoFilters(void) const;
 
+  /// <returns>
+  /// The current version of the filter graph, or nullptr if no filters have been registered
+  /// </returns>
+  /// <remarks>
+  /// This method does not block.  The returned version is immutable, and is unaffected by subsequent
+  /// calls to AddSubscriber or RemoveSubscriber.
+  /// </remarks>
+  std::shared_ptr<const autowiring::FilterGraph> GetFilterGraph(void) const {
+    return std::atomic_load(&m_filterGraph);
+  }
+
   /// <summary>
-  /// Creates a linked list of saturation counters
+  /// Creates a linked list of saturation counters for the filters in the specified graph
   /// </summary>
   /// <returns>The first element in the list, or nullptr if the list is empty</returns>
-  autowiring::SatCounter* CreateSatCounterList(void) const;
+  autowiring::SatCounter* CreateSatCounterList(const autowiring::FilterGraph& graph) const;
 
   // CoreRunnable overrides:
   bool OnStart(void) override;
@@ -119,7 +205,8 @@ public:
   /// <remarks>
   /// This method will not retroactively modify packets that have already been issued with the specified
   /// AutoFilter on it.  Only packets that are issued after this method returns will lack the presence of
-  /// the autoFilter described by the parameter.
+  /// the autoFilter described by the parameter.  Similarly, a filter added by AddSubscriber is only
+  /// attached to packets issued after AddSubscriber returns.
   /// </remarks>
   void RemoveSubscriber(const autowiring::AutoFilterDescriptor& autoFilter);
 
@@ -176,14 +263,95 @@ public:
   /// <returns>
   /// The most recently issued packet, or possibly nullptr if that packet has already been destroyed
   /// </returns>
+  /// <remarks>
+  /// Packets issued in unsequenced mode are not reported by this method
+  /// </remarks>
   std::shared_ptr<AutoPacket> CurrentPacket(void);
 
+  /// <summary>
+  /// Enables or disables unsequenced packet issue
+  /// </summary>
+  /// <remarks>
+  /// Ordinarily each packet is issued as the successor of the one before it, which requires that all
+  /// producers serialize on this factory's lock.  In unsequenced mode, each call to NewPacket instead
+  /// constructs an independent packet without taking any lock, so that many producer threads may
+  /// issue packets concurrently.  Unsequenced packets have no predecessor, so the mode is only used
+  /// while no filter in the factory takes a timeshifted input; NewPacket falls back to sequenced issue
+  /// otherwise, as it also does under a bounded admission policy.
+  ///
+  /// Packets issued while a filter with timeshifted inputs is being added may not observe their
+  /// priors, so this mode should only be enabled for pipelines which do not use auto_prev.
+  /// </remarks>
+  void EnableUnsequencedIssue(bool enabled = true) { m_unsequenced = enabled; }
+
+  /// <returns>True if unsequenced packet issue is enabled</returns>
+  bool IsUnsequencedIssueEnabled(void) const { return m_unsequenced; }
+
   /// <summary>
   /// Obtains a new packet from the object pool and configures it with the current
   /// satisfaction graph
   /// </summary>
+  /// <remarks>
+  /// Under the Block admission policy, this method blocks while the factory is at capacity.  Callers
+  /// which hold outstanding packets from this factory must not call this method on a thread that is
+  /// responsible for releasing those packets.
+  /// </remarks>
   std::shared_ptr<AutoPacket> NewPacket(void);
 
+  /// <summary>
+  /// Obtains a new packet which must be processed by the specified deadline
+  /// </summary>
+  /// <remarks>
+  /// Once the deadline has passed, skippable filters are no longer called on the returned packet, and
+  /// the outputs of those filters are marked unsatisfiable instead.  Filters which are not skippable
+  /// are unaffected.  See autowiring::skippable_of for how a filter declares itself skippable.
+  /// </remarks>
+  std::shared_ptr<AutoPacket> NewPacket(std::chrono::steady_clock::time_point deadline);
+
+  /// <summary>
+  /// Obtains a new packet which must be processed within the specified time of being issued
+  /// </summary>
+  std::shared_ptr<AutoPacket> NewPacket(std::chrono::nanoseconds budget);
+
+  /// <summary>
+  /// Identical to NewPacket, except that nullptr is returned rather than blocking if the factory is at
+  /// capacity under the Block admission policy
+  /// </summary>
+  std::shared_ptr<AutoPacket> TryNewPacket(void);
+
+  /// <summary>
+  /// Configures the behavior of the factory when the number of outstanding packets reaches a limit
+  /// </summary>
+  /// <param name="policy">The policy to apply when the limit is reached</param>
+  /// <param name="maxOutstanding">The maximum number of outstanding packets, ignored if the policy is Unbounded</param>
+  void SetAdmissionPolicy(autowiring::AdmissionPolicy policy, size_t maxOutstanding = 0);
+
+  /// <returns>The current admission policy</returns>
+  autowiring::AdmissionPolicy GetAdmissionPolicy(void) const;
+
+  /// <returns>The number of packets refused by TryNewPacket because the factory was at capacity</returns>
+  uint64_t GetRejectedPacketCount(void) const { return m_nRejected; }
+
+  /// <returns>The number of outstanding packets shed under the DropOldest admission policy</returns>
+  uint64_t GetDroppedPacketCount(void) const { return m_nDropped; }
+
+  /// <summary>
+  /// Called by each issued AutoPacket when it is destroyed, to admit any waiting packet requests
+  /// </summary>
+  /// <param name="shed">True if the packet was shed under the DropOldest admission policy</param>
+  void PacketReleased(bool shed);
+
+  /// <summary>
+  /// Called by AutoPacket when the specified skippable filter is skipped on a packet past its deadline
+  /// </summary>
+  void RecordSkippedFilter(const autowiring::SatCounter& satCounter);
+
+  /// <returns>The number of times each skippable filter has been skipped on packets past their deadline</returns>
+  /// <remarks>
+  /// Only filters which are currently registered and have been skipped at least once are reported
+  /// </remarks>
+  std::vector<autowiring::AutoFilterSkipCount> GetSkippedFilterCounts(void) const;
+
   std::shared_ptr<AutoPacketInternal> ConstructPacket(void);
 
   /// <returns>the number of outstanding AutoPackets</returns>
@@ -196,21 +364,46 @@ public:
   /// <param name="duration">
   /// The total lifetime of the AutoPacket that is being Finalized
   /// </param>
+  /// <remarks>
+  /// This method does not block, and may be called concurrently with any of the statistics queries.
+  /// </remarks>
   void RecordPacketDuration(std::chrono::nanoseconds duration);
 
+  /// <summary>
+  /// Packet lifetime statistics gathered over a window of time
+  /// </summary>
+  struct PacketStatistics {
+    // Lifetimes of the packets destroyed during the window
+    autowiring::duration_histogram::snapshot lifetime;
+
+    // The length of the window, measured from the last statistics reset
+    std::chrono::nanoseconds window;
+
+    /// <returns>The number of packets destroyed per second over the window</returns>
+    double rate(void) const {
+      return window.count() ? lifetime.count * 1e9 / window.count() : 0.0;
+    }
+  };
+
+  /// <summary>
+  /// Obtains the packet lifetime statistics gathered since the most recent reset
+  /// </summary>
+  /// <param name="reset">True if a new window should be started</param>
+  /// <remarks>
+  /// Taking statistics does not block packet destruction.  When reset is true, each packet lifetime is
+  /// reported exactly once, either in the returned statistics or in those of the next window.
+  /// </remarks>
+  PacketStatistics GetPacketStatistics(bool reset = false);
+
   /// <summary>
   /// Returns the number of packets which have recorded duration statistics
   /// since the most recent statistics reset.
   /// </summary>
-  long long GetTotalPacketCount(void) { return m_packetCount; }
+  long long GetTotalPacketCount(void) { return static_cast<long long>(m_packetLifetimes.count()); }
 
   /// <summary>
   /// Returns the mean lifespan of AutoPackets in nanoseconds since the last statistics reset.
   /// </summary>
-  /// <remarks>
-  /// If the factory is left to run for an extended period of time without a reset
-  /// the mean will decrease erroneously due to saturation of the accumulator.
-  /// </remarks>
   double GetMeanPacketLifetime(void);
 
   /// <summary>
@@ -218,15 +411,47 @@ public:
   /// most recent statistics reset.
   /// </summary>
   /// <remarks>
-  /// If the factory is left to run for an extended period of time without a reset
-  /// the standard deviation will behave erraticly due to saturation of the accumulators.
+  /// The standard deviation is computed from the lifetime histogram, and is therefore approximate.
   /// </remarks>
   double GetPacketLifetimeStandardDeviation(void);
 
+  /// <returns>
+  /// The approximate lifespan below which the specified fraction of AutoPackets fall, since the most
+  /// recent statistics reset
+  /// </returns>
+  /// <param name="fraction">A value between 0 and 1, for instance 0.99 for the 99th percentile</param>
+  std::chrono::nanoseconds GetPacketLifetimePercentile(double fraction);
+
   /// <summary>
   /// Resets the statistics accumulators stored by the AutoPacketFactory.
   /// </summary>
   void ResetPacketStatistics(void);
+
+  /// <summary>
+  /// Enables or disables per-filter execution profiling
+  /// </summary>
+  /// <remarks>
+  /// Profiling takes effect on packets issued after this call.  When disabled, the only cost imposed on
+  /// filter calls is a single pointer check.
+  /// </remarks>
+  void EnableFilterProfiling(bool enabled = true) { m_profiling = enabled; }
+
+  /// <returns>True if per-filter execution profiling is enabled</returns>
+  bool IsFilterProfilingEnabled(void) const { return m_profiling; }
+
+  /// <returns>
+  /// A copy of the execution profile of every filter which has been called since profiling was enabled
+  /// </returns>
+  /// <param name="reset">True if the profiles should be cleared as they are copied</param>
+  std::vector<autowiring::AutoFilterProfileSnapshot> GetFilterProfiles(bool reset = false);
+
+  /// <summary>
+  /// Writes all filter profiles to the specified stream as comma-separated values, one line per filter
+  /// </summary>
+  /// <remarks>
+  /// All times are reported in nanoseconds
+  /// </remarks>
+  void WriteFilterProfiles(std::ostream& os);
 };
 
 // @cond
@@ -15,7 +15,8 @@
 
 using namespace autowiring;
 
-AutoPacketGraph::AutoPacketGraph(void)
+AutoPacketGraph::AutoPacketGraph(size_t sampleEvery) :
+  m_sampleEvery(sampleEvery ? sampleEvery : 1)
 {
   AutoCurrentContext()->newObject += [this] (const CoreObjectDescriptor&) { LoadEdges(); };
 }
@@ -28,6 +29,7 @@ void AutoPacketGraph::LoadEdges() {
   std::list<AutoFilterDescriptor> descriptors;
   m_factory->AppendAutoFiltersTo(descriptors);
 
+  bool added = false;
   for (auto& descriptor : descriptors) {
     for(auto pCur = descriptor.GetAutoFilterArguments(); *pCur; pCur++) {
       auto_id id = pCur->id;
@@ -48,19 +50,47 @@ void AutoPacketGraph::LoadEdges() {
       }
 
       DeliveryEdge edge {id, descriptor, arg_type};
-      if (m_deliveryGraph.find(edge) == m_deliveryGraph.end()) {
-        m_deliveryGraph[edge] = 0;
+      if (m_edgeIds.find(edge) == m_edgeIds.end()) {
+        // Assign the next dense ID to this edge
+        m_edgeIds[edge] = m_edges.size();
+        m_edges.push_back(edge);
+        m_counters.emplace_back(0);
+        added = true;
       }
     }
   }
+
+  if (!added)
+    return;
+
+  // Publish a new index so that packets being torn down can find their counters without locking
+  auto index = std::make_shared<t_edgeIndex>();
+  for (size_t i = 0; i < m_edges.size(); i++) {
+    const auto& descriptor = m_edges[i].descriptor;
+    (*index)[t_filterKey(descriptor.GetAutoFilter().ptr(), descriptor.GetCall())].push_back(&m_counters[i]);
+  }
+  std::atomic_store(&m_index, std::shared_ptr<const t_edgeIndex>(index));
 }
 
-void AutoPacketGraph::RecordDelivery(auto_id id, const AutoFilterDescriptor& descriptor, DeliveryEdge::ArgType arg_type) {
-  DeliveryEdge edge { id, descriptor, arg_type };
+void AutoPacketGraph::RecordDeliveries(AutoPacket& packet) {
+  auto index = std::atomic_load(&m_index);
+  if (!index)
+    return;
+
+  // Every argument of a filter that ran on this packet was delivered
+  std::lock_guard<std::mutex> lk(packet.m_lock);
+  for (auto* satCounter = packet.m_firstCounter; satCounter; satCounter = satCounter->flink) {
+    if (satCounter->remaining)
+      continue;
+
+    auto q = index->find(t_filterKey(satCounter->GetAutoFilter().ptr(), satCounter->GetCall()));
+    if (q == index->end())
+      // Not a filter we know about, such as the AutoPacketGraph itself or an ad-hoc recipient
+      continue;
 
-  auto itr = m_deliveryGraph.find(edge);
-  assert(itr != m_deliveryGraph.end());
-  itr->second++;
+    for (auto* counter : q->second)
+      counter->fetch_add(1, std::memory_order_relaxed);
+  }
 }
 
 bool AutoPacketGraph::OnStart(void) {
@@ -69,32 +99,22 @@ bool AutoPacketGraph::OnStart(void) {
 }
 
 void AutoPacketGraph::AutoFilter(AutoPacket& packet) {
+  if (m_nSeen++ % m_sampleEvery)
+    return;
+
   packet.AddTeardownListener([this, &packet] () {
-    for (auto& cur : packet.GetDecorations()) {
-      auto& decoration = cur.second;
-      auto type = cur.first.id;
-
-      for (auto& modifier : decoration.m_modifiers)
-        if (modifier.satCounter && !modifier.satCounter->remaining)
-          RecordDelivery(type, *modifier.satCounter, DeliveryEdge::ArgType::Rvalue);
-
-      for (auto& publisher : decoration.m_publishers)
-        if (!publisher->remaining)
-          RecordDelivery(type, *publisher, DeliveryEdge::ArgType::Output);
-
-      for (auto& subscriber : decoration.m_subscribers) {
-        // Skip the AutoPacketGraph
-        auto_id descType = m_factory->GetContext()->GetAutoTypeId(subscriber.satCounter->GetAutoFilter());
-        if (descType == auto_id_t<AutoPacketGraph>{})
-          continue;
-
-        if (!subscriber.satCounter->remaining)
-          RecordDelivery(type, *subscriber.satCounter, DeliveryEdge::ArgType::Input);
-      }
-    }
+    RecordDeliveries(packet);
   });
 }
 
+AutoPacketGraph::t_deliveryEdges AutoPacketGraph::GetDeliveryCounts(void) const {
+  std::lock_guard<std::mutex> lk(m_lock);
+  t_deliveryEdges retVal;
+  for (size_t i = 0; i < m_edges.size(); i++)
+    retVal[m_edges[i]] = m_counters[i].load(std::memory_order_relaxed);
+  return retVal;
+}
+
 bool AutoPacketGraph::WriteGV(const std::string& filename, bool numPackets) const {
   std::ofstream file(filename.c_str());
   if (!file && !file.good()) {
@@ -103,13 +123,11 @@ bool AutoPacketGraph::WriteGV(const std::string& filename, bool numPackets) cons
 
   file << "digraph \"" << autowiring::demangle(CoreContext::CurrentContext()->GetSigilType()) << " context\" {" << std::endl;
 
-  std::lock_guard<std::mutex> lk(m_lock);
-
   // Containers for the unique types and descriptors
   std::unordered_set<std::string> typeNames;
   std::unordered_set<std::string> descriptorNames;
 
-  for (auto& itr : m_deliveryGraph) {
+  for (auto& itr : GetDeliveryCounts()) {
     auto& edge = itr.first;
     auto type = edge.type_info;
     auto& descriptor = edge.descriptor;
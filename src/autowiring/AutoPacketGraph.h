@@ -5,7 +5,11 @@
 #include "AutoPacketFactory.h"
 #include "Autowired.h"
 #include "CoreRunnable.h"
+#include <atomic>
+#include <deque>
+#include MEMORY_HEADER
 #include STL_UNORDERED_MAP
+#include <vector>
 
 /// \internal
 /// <summary>
@@ -39,14 +43,17 @@ struct DeliveryEdge
 };
 
 /// <summary>
-/// Using the same hash function as the AutoFilterDescriptor
+/// Combines the type, the AutoFilter, and the argument direction of the edge
 /// </summary>
 namespace std {
   template<>
   struct hash<DeliveryEdge>
   {
     size_t operator()(const DeliveryEdge& edge) const {
-      return (size_t) edge.descriptor.GetAutoFilter().ptr();
+      size_t retVal = (size_t) edge.descriptor.GetAutoFilter().ptr();
+      retVal = retVal * 31 + (size_t) edge.descriptor.GetCall();
+      retVal = retVal * 31 + (size_t) edge.type_info.block;
+      return retVal * 31 + (size_t) edge.arg_type;
     }
   };
 }
@@ -54,22 +61,53 @@ namespace std {
 /// <summary>
 /// Graphical visualization of AutoPackets
 /// </summary>
+/// <remarks>
+/// Deliveries are counted with one atomic counter per edge, so packets may be torn down concurrently
+/// without contention on the graph.  Counters are only merged into an edge map when the graph is
+/// written or queried.  To further reduce overhead, the graph may be configured to observe only one
+/// in every N packets, in which case the reported counts are those of the sampled packets.
+/// </remarks>
 class AutoPacketGraph:
   public CoreRunnable
 {
 public:
-  AutoPacketGraph(void);
+  /// <param name="sampleEvery">Observe one packet out of this many</param>
+  AutoPacketGraph(size_t sampleEvery = 1);
   ~AutoPacketGraph(void);
 
   typedef std::unordered_map<DeliveryEdge, size_t, std::hash<DeliveryEdge>> t_deliveryEdges;
 
 protected:
-  // A mapping of an edge to the number of times it was delivered
-  t_deliveryEdges m_deliveryGraph;
+  // Identifies an AutoFilter by its instance and call
+  typedef std::pair<const void*, autowiring::t_extractedCall> t_filterKey;
+  struct filter_key_hash {
+    size_t operator()(const t_filterKey& key) const {
+      return (size_t) key.first * 31 + (size_t) key.second;
+    }
+  };
+
+  // For each AutoFilter, the delivery counters of all of its edges.  Immutable once published, a new
+  // index is constructed whenever edges are added.
+  typedef std::unordered_map<t_filterKey, std::vector<std::atomic<size_t>*>, filter_key_hash> t_edgeIndex;
+
+  // All known edges, and their delivery counters, both indexed by dense edge ID.  Both collections
+  // are only appended to, so that pointers to counters remain valid.
+  std::vector<DeliveryEdge> m_edges;
+  std::deque<std::atomic<size_t>> m_counters;
+
+  // Mapping from an edge to its ID
+  std::unordered_map<DeliveryEdge, size_t> m_edgeIds;
+
+  // The current edge index, accessed atomically
+  std::shared_ptr<const t_edgeIndex> m_index;
 
-  // A lock for this type
+  // A lock for this type, guards everything except for the counters and the index
   mutable std::mutex m_lock;
 
+  // Sampling period, and the number of packets seen so far
+  std::atomic<size_t> m_sampleEvery;
+  std::atomic<size_t> m_nSeen{0};
+
   // Reference to the AutoPacketFactory
   AutoRequired<AutoPacketFactory> m_factory;
 
@@ -82,9 +120,9 @@ protected:
   void LoadEdges();
 
   /// <summary>
-  /// Record the delivery of a packet and increment the number of times the packet has been delivered
+  /// Record the delivery of every edge of every AutoFilter that was satisfied on the packet
   /// </summary>
-  void RecordDelivery(auto_id id, const autowiring::AutoFilterDescriptor& descriptor, DeliveryEdge::ArgType arg_type);
+  void RecordDeliveries(AutoPacket& packet);
 
   void NewObject(CoreContext&, const autowiring::CoreObjectDescriptor&);
 
@@ -92,11 +130,24 @@ protected:
   virtual bool OnStart(void) override;
 
 public:
+  /// <summary>
+  /// Changes the sampling period, takes effect on the next packet
+  /// </summary>
+  void SetSampleRate(size_t sampleEvery) { m_sampleEvery = sampleEvery ? sampleEvery : 1; }
+
+  /// <returns>The number of packets out of which one is observed</returns>
+  size_t GetSampleRate(void) const { return m_sampleEvery; }
+
   /// <summary>
   /// Get a copy of the packet via AutoFilter
   /// </summary>
   void AutoFilter(AutoPacket& packet);
 
+  /// <returns>
+  /// The number of times each edge has been delivered, over all observed packets
+  /// </returns>
+  t_deliveryEdges GetDeliveryCounts(void) const;
+
   /// <summary>
   /// Write the graph to a file in graphviz format
   /// </summary>
@@ -14,12 +14,18 @@ AutoPacketInternal::AutoPacketInternal(AutoPacketFactory& factory, std::shared_p
 
 AutoPacketInternal::~AutoPacketInternal(void) {}
 
-void AutoPacketInternal::Initialize(bool isFirstPacket) {
+void AutoPacketInternal::Initialize(bool isFirstPacket, std::shared_ptr<const FilterGraph> graph, std::chrono::steady_clock::time_point deadline) {
   // Mark init time of packet
   this->m_initTime = std::chrono::high_resolution_clock::now();
 
-  // Traverse all descendant contexts, adding their packet subscriber vectors one at a time:
-  m_firstCounter = m_parentFactory->CreateSatCounterList();
+  // The deadline must be in place before any filter has a chance to run
+  m_deadline.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+
+  // Construct satisfaction counters from the pinned graph, later changes to the factory's subscribers
+  // do not affect this packet
+  m_filterGraph = std::move(graph);
+  if (m_filterGraph)
+    m_firstCounter = m_parentFactory->CreateSatCounterList(*m_filterGraph);
 
   // Find all subscribers with no required or optional arguments:
   std::vector<SatCounter*> callCounters;
@@ -34,22 +40,33 @@ void AutoPacketInternal::Initialize(bool isFirstPacket) {
     }
   }
 
-  // Mark timeshifted decorations as unsatisfiable on the first packet
-  if (isFirstPacket)
-    for (auto& dec : m_decoration_map) {
-      auto& key = dec.first;
-      if (key.tshift) {
-        MarkUnsatisfiable(key);
-        MarkSuccessorsUnsatisfiable(key);
+  // Mark timeshifted decorations as unsatisfiable on the first packet, and on as many of its
+  // successors as would otherwise have looked back to a packet preceding the first one
+  if (isFirstPacket) {
+    std::vector<DecorationKey> timeshifted;
+    {
+      std::lock_guard<std::mutex> lk(m_lock);
+      for (auto& dec : m_decoration_map)
+        if (dec.first.tshift)
+          timeshifted.push_back(dec.first);
+    }
+
+    for (auto& key : timeshifted) {
+      auto cur = std::static_pointer_cast<AutoPacketInternal>(shared_from_this());
+      for (int i = 0; i < key.tshift; i++) {
+        cur->MarkUnsatisfiable(key);
+        if (i + 1 < key.tshift)
+          cur = cur->SuccessorInternal();
       }
     }
+  }
 
   // Call all subscribers with no required or optional arguments:
   // NOTE: This may result in decorations that cause other subscribers to be called.
   {
     autowiring::AutoCurrentPacketPusher pkt(*this);
     for (SatCounter* call : callCounters)
-      call->GetCall()(call->GetAutoFilter().ptr(), *this);
+      InvokeFilter(*call);
   }
 }
 
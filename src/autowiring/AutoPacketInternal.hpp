@@ -21,11 +21,19 @@ public:
   /// It is not called when the Packet is created since that could result in
   /// spurious calls when no packet is issued.
   /// </remarks>
-  void Initialize(bool isFirstPacket);
+  /// <param name="isFirstPacket">True if this is the first packet issued by the factory</param>
+  /// <param name="graph">The version of the filter graph to be pinned by this packet, may be nullptr</param>
+  /// <param name="deadline">The deadline of the packet, or time_point::max() for no deadline</param>
+  void Initialize(bool isFirstPacket, std::shared_ptr<const autowiring::FilterGraph> graph, std::chrono::steady_clock::time_point deadline = (std::chrono::steady_clock::time_point::max)());
 
   /// <summary>
   ///
   /// </summary>
   std::shared_ptr<AutoPacketInternal> SuccessorInternal(void);
+
+  /// <summary>
+  /// Sheds this packet, no further filters will be called on it
+  /// </summary>
+  void Shed(void) { m_shed = true; }
 };
 
@@ -0,0 +1,230 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "AutoPacketRecorder.h"
+#include "AutoPacketFactory.h"
+#include "autowiring_error.h"
+#include <string.h>
+#include THREAD_HEADER
+
+static const char sc_magic[4] = { 'A', 'W', 'P', 'R' };
+static const char sc_channelRecord = 'C';
+static const char sc_packetRecord = 'P';
+
+const uint32_t AutoPacketRecorder::Version;
+
+AutoPacketRecorder::AutoPacketRecorder(void) {}
+
+AutoPacketRecorder::~AutoPacketRecorder(void) {}
+
+void AutoPacketRecorder::AddEntry(PendingPacket& pending, uint32_t channel, const std::string& bytes) {
+  std::lock_guard<std::mutex> lk(pending.lock);
+  Append(pending.entries, channel);
+  Append(pending.entries, static_cast<uint32_t>(bytes.size()));
+  pending.entries += bytes;
+  pending.count++;
+}
+
+void AutoPacketRecorder::WriteRecordUnsafe(const std::string& record) {
+  if (!m_file.is_open())
+    return;
+
+  m_file.write(record.data(), record.size());
+  if (!m_file) {
+    // Anything written after a failed write could not be parsed, so stop here
+    m_failed = true;
+    m_file.close();
+  }
+}
+
+void AutoPacketRecorder::WriteChannelUnsafe(uint32_t id) {
+  const std::string& name = m_channels[id].name;
+  std::string record(1, sc_channelRecord);
+  Append(record, id);
+  Append(record, static_cast<uint32_t>(name.size()));
+  record += name;
+  WriteRecordUnsafe(record);
+}
+
+void AutoPacketRecorder::Write(const PendingPacket& pending) {
+  std::string record(1, sc_packetRecord);
+  Append(record, static_cast<uint64_t>(pending.ts.count()));
+  Append(record, pending.count);
+  record += pending.entries;
+
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (!m_file.is_open())
+    return;
+  WriteRecordUnsafe(record);
+  if (m_file.is_open())
+    m_nRecorded++;
+}
+
+void AutoPacketRecorder::Open(const std::string& path) {
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (m_file.is_open())
+    m_file.close();
+
+  m_file.clear();
+  m_file.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_file.is_open())
+    throw autowiring_error("Failed to open " + path + " for recording");
+  m_failed = false;
+
+  std::string header(sc_magic, sizeof(sc_magic));
+  Append(header, Version);
+  WriteRecordUnsafe(header);
+
+  // Channels named before the file was opened must be defined before any packet refers to them
+  for (uint32_t i = 0; i < m_channels.size(); i++)
+    WriteChannelUnsafe(i);
+
+  // Writes are buffered, flush so that a file which cannot be written at all is detected here
+  if (m_file.is_open() && !m_file.flush()) {
+    m_failed = true;
+    m_file.close();
+  }
+  if (m_failed)
+    throw autowiring_error("Failed to write the header of " + path);
+
+  m_epoch = std::chrono::steady_clock::now();
+  m_nRecorded = 0;
+}
+
+void AutoPacketRecorder::Close(void) {
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (m_file.is_open()) {
+    // Buffered records are only known to have been written once they have been flushed
+    m_file.close();
+    if (!m_file)
+      m_failed = true;
+  }
+  if (m_failed)
+    throw autowiring_error("Failed to write the recording, the file is truncated");
+}
+
+void AutoPacketRecorder::AutoFilter(AutoPacket& packet) {
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (!m_file.is_open() || m_channels.empty())
+    return;
+
+  auto pending = std::make_shared<PendingPacket>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch)
+  );
+
+  // Captured decorations only call back into the pending packet, never into this recorder, so it is
+  // safe to attach them while holding our lock
+  for (auto& channel : m_channels)
+    channel.attach(packet, pending);
+
+  // The packet may outlive this recorder
+  std::weak_ptr<AutoPacketRecorder> self = GetSelf<AutoPacketRecorder>();
+  packet.AddTeardownListener([self, pending] {
+    if (auto recorder = self.lock())
+      recorder->Write(*pending);
+  });
+}
+
+// Reads a value of type T from the mapped view and advances the cursor, or returns false if fewer than
+// sizeof(T) bytes remain
+template<class T>
+static bool Read(const uint8_t*& cur, const uint8_t* end, T& value) {
+  if (static_cast<size_t>(end - cur) < sizeof(T))
+    return false;
+  memcpy(&value, cur, sizeof(T));
+  cur += sizeof(T);
+  return true;
+}
+
+AutoPacketReplayer::AutoPacketReplayer(const std::string& path) :
+  m_file(path)
+{
+  const uint8_t* cur = m_file.data();
+  const uint8_t* end = cur + m_file.size();
+
+  uint32_t version = 0;
+  bool valid = m_file.size() >= sizeof(sc_magic) && !memcmp(cur, sc_magic, sizeof(sc_magic));
+  if (valid) {
+    cur += sizeof(sc_magic);
+    valid = Read(cur, end, version);
+  }
+  if (!valid)
+    throw autowiring_error(path + " is not a packet recording");
+  if (version != AutoPacketRecorder::Version)
+    throw autowiring_error(path + " was recorded with an unsupported version of the recording format");
+
+  // Index every complete record, stopping at the first truncated one
+  for (char kind; Read(cur, end, kind);) {
+    if (kind == sc_channelRecord) {
+      uint32_t id, len;
+      if (!Read(cur, end, id) || !Read(cur, end, len) || static_cast<size_t>(end - cur) < len)
+        break;
+      if (id != m_channels.size())
+        throw autowiring_error(path + " contains an out-of-sequence channel definition");
+      m_channels.push_back(std::string(reinterpret_cast<const char*>(cur), len));
+      cur += len;
+    }
+    else if (kind == sc_packetRecord) {
+      const uint8_t* packet = cur;
+      uint64_t ts;
+      uint32_t count;
+      if (!Read(cur, end, ts) || !Read(cur, end, count))
+        break;
+
+      bool complete = true;
+      for (uint32_t i = 0; complete && i < count; i++) {
+        uint32_t channel, len;
+        complete = Read(cur, end, channel) && Read(cur, end, len) && static_cast<size_t>(end - cur) >= len;
+        if (complete && channel >= m_channels.size())
+          throw autowiring_error(path + " refers to an undefined channel");
+        if (complete)
+          cur += len;
+      }
+      if (!complete)
+        break;
+      m_packets.push_back(packet);
+    }
+    else
+      throw autowiring_error(path + " contains an unrecognized record");
+  }
+}
+
+AutoPacketReplayer::~AutoPacketReplayer(void) {}
+
+size_t AutoPacketReplayer::Run(AutoPacketFactory& factory, Pacing pacing) {
+  // Resolve channels to decoders up front, so that the replay loop does no lookups
+  std::vector<t_decoder> decoders(m_channels.size(), nullptr);
+  for (size_t i = 0; i < m_channels.size(); i++) {
+    auto q = m_decoders.find(m_channels[i]);
+    if (q != m_decoders.end())
+      decoders[i] = q->second;
+  }
+
+  const uint8_t* end = m_file.data() + m_file.size();
+  const auto start = std::chrono::steady_clock::now();
+  uint64_t firstTs = 0;
+  size_t nIssued = 0;
+  for (const uint8_t* cur : m_packets) {
+    // Records were validated when the file was indexed
+    uint64_t ts;
+    uint32_t count;
+    Read(cur, end, ts);
+    Read(cur, end, count);
+
+    if (!nIssued)
+      firstTs = ts;
+    if (pacing == Pacing::Original && ts > firstTs)
+      std::this_thread::sleep_until(start + std::chrono::nanoseconds(ts - firstTs));
+
+    auto packet = factory.NewPacket();
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t channel, len;
+      Read(cur, end, channel);
+      Read(cur, end, len);
+      if (decoders[channel])
+        decoders[channel](*packet, cur, len);
+      cur += len;
+    }
+    nIssued++;
+  }
+  return nIssued;
+}
@@ -0,0 +1,240 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "altitude.h"
+#include "AutoPacket.h"
+#include "ContextMember.h"
+#include "demangle.h"
+#include "MemoryMappedFile.h"
+#include "packet_codec.h"
+#include <atomic>
+#include CHRONO_HEADER
+#include <cstdint>
+#include FUNCTIONAL_HEADER
+#include <fstream>
+#include <map>
+#include MEMORY_HEADER
+#include MUTEX_HEADER
+#include <string>
+#include <vector>
+
+class AutoPacketFactory;
+
+/// <summary>
+/// Records selected decorations of every packet to a binary file, for later replay by AutoPacketReplayer
+/// </summary>
+/// <remarks>
+/// Add this type to a context with an AutoPacketFactory, name the decoration types to be captured
+/// with Record, and then Open a file.  Each captured decoration is encoded with autowiring::packet_codec
+/// as soon as it is attached, and the packet is written to the file along with the time at which it
+/// was issued once the packet is destroyed.  Packets are therefore written in order of completion
+/// rather than order of issue.
+///
+/// The file consists of a header followed by a sequence of records, in the byte order of the recording
+/// machine:
+///
+///   header:  "AWPR" uint32 version
+///   channel: 'C' uint32 id, uint32 length, type name
+///   packet:  'P' uint64 time in ns, uint32 count, then count times: uint32 channel, uint32 length, bytes
+///
+/// Channels associate each decoration type with its demangled name so that the replayer can match the
+/// recorded decorations to its own types.
+///
+/// If a write to the file fails, for instance because the disk is full, the file is closed at that
+/// point and the failure is reported by IsFailed and by Close.
+/// </remarks>
+class AutoPacketRecorder:
+  public ContextMember
+{
+public:
+  AutoPacketRecorder(void);
+  ~AutoPacketRecorder(void);
+
+  // Decoration capture must be in place before any other filter has a chance to attach decorations
+  static const autowiring::altitude altitude = autowiring::altitude::Highest;
+
+  static const uint32_t Version = 1;
+
+private:
+  // Decorations captured from a single packet, encoded in the file format as they arrive
+  struct PendingPacket {
+    PendingPacket(std::chrono::nanoseconds ts) :
+      ts(ts)
+    {}
+
+    const std::chrono::nanoseconds ts;
+
+    // Decorations may be attached from several threads at once
+    std::mutex lock;
+    std::string entries;
+    uint32_t count = 0;
+  };
+
+  struct Channel {
+    std::string name;
+
+    // Arranges for decorations of this channel's type to be captured from the packet
+    std::function<void(AutoPacket&, const std::shared_ptr<PendingPacket>&)> attach;
+  };
+
+  // Guards the channel collection and the file
+  std::mutex m_lock;
+  std::vector<Channel> m_channels;
+  std::ofstream m_file;
+
+  // The time of the most recent call to Open, packet times are recorded relative to this point
+  std::chrono::steady_clock::time_point m_epoch;
+
+  std::atomic<uint64_t> m_nRecorded{0};
+
+  // Set if a write to the current file failed
+  std::atomic<bool> m_failed{false};
+
+  // Appends the binary representation of a value to a buffer
+  template<class T>
+  static void Append(std::string& buf, T value) {
+    buf.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  // Appends a single encoded decoration to a packet
+  static void AddEntry(PendingPacket& pending, uint32_t channel, const std::string& bytes);
+
+  // Writes a record to the file if it is open, closing the file if the write fails.  Must be called with
+  // m_lock held.
+  void WriteRecordUnsafe(const std::string& record);
+
+  // Writes the definition of the specified channel, must be called with m_lock held
+  void WriteChannelUnsafe(uint32_t id);
+
+  // Writes a completed packet to the file, if it is open
+  void Write(const PendingPacket& pending);
+
+public:
+  /// <summary>
+  /// Begins recording to the specified file, replacing its contents
+  /// </summary>
+  /// <remarks>
+  /// Throws autowiring_error if the file cannot be created.  Any previously open file is closed.
+  /// </remarks>
+  void Open(const std::string& path);
+
+  /// <summary>
+  /// Stops recording and closes the file
+  /// </summary>
+  /// <remarks>
+  /// Packets still outstanding when the file is closed are not recorded.  Throws autowiring_error if
+  /// any part of the recording could not be written, in which case the file is truncated.
+  /// </remarks>
+  void Close(void);
+
+  /// <returns>True if a write to the file failed since it was opened</returns>
+  bool IsFailed(void) const { return m_failed; }
+
+  /// <summary>
+  /// Captures decorations of type T on all packets issued from this point on
+  /// </summary>
+  /// <remarks>
+  /// Only one decoration of each type is expected on a packet.  This method is idempotent.
+  /// </remarks>
+  template<class T>
+  void Record(void) {
+    std::string name = autowiring::demangle(auto_id_t<T>{});
+
+    std::lock_guard<std::mutex> lk(m_lock);
+    for (auto& channel : m_channels)
+      if (channel.name == name)
+        return;
+
+    uint32_t id = static_cast<uint32_t>(m_channels.size());
+    m_channels.push_back(Channel{
+      name,
+      [id] (AutoPacket& packet, const std::shared_ptr<PendingPacket>& pending) {
+        packet += [id, pending] (const T& value) {
+          std::string bytes;
+          autowiring::packet_codec<T>::encode(value, bytes);
+          AddEntry(*pending, id, bytes);
+        };
+      }
+    });
+    WriteChannelUnsafe(id);
+  }
+
+  /// <returns>The number of packets written to the file since it was opened</returns>
+  uint64_t GetRecordedPacketCount(void) const { return m_nRecorded; }
+
+  /// <summary>
+  /// Arranges for the selected decorations of the packet to be captured
+  /// </summary>
+  void AutoFilter(AutoPacket& packet);
+};
+
+/// <summary>
+/// Re-injects packets recorded by AutoPacketRecorder into an AutoPacketFactory
+/// </summary>
+/// <remarks>
+/// The recording is memory-mapped, and each decoration is decoded directly from the mapped view when
+/// its packet is issued.  Decoration types must be named with Replay before Run is called; recorded
+/// decorations of any other type are not attached.  A recording which ends in a partially written
+/// record, for instance because the recording process was terminated, is replayed up to the last
+/// complete packet.
+/// </remarks>
+class AutoPacketReplayer {
+public:
+  /// <summary>
+  /// Maps and indexes the specified recording
+  /// </summary>
+  /// <remarks>
+  /// Throws autowiring_error if the file cannot be mapped, or is not a recording
+  /// </remarks>
+  AutoPacketReplayer(const std::string& path);
+  ~AutoPacketReplayer(void);
+
+  enum class Pacing {
+    // Packets are issued at the intervals at which they were originally issued
+    Original,
+
+    // Packets are issued as fast as possible
+    Unpaced
+  };
+
+private:
+  typedef void(*t_decoder)(AutoPacket& packet, const uint8_t* data, size_t len);
+
+  const autowiring::MemoryMappedFile m_file;
+
+  // Recorded channel names, indexed by channel identifier
+  std::vector<std::string> m_channels;
+
+  // The start of each packet record in the mapped view
+  std::vector<const uint8_t*> m_packets;
+
+  // Decoders registered with Replay, indexed by type name
+  std::map<std::string, t_decoder> m_decoders;
+
+  template<class T>
+  static void Decode(AutoPacket& packet, const uint8_t* data, size_t len) {
+    T value;
+    autowiring::packet_codec<T>::decode(data, len, value);
+    packet.Decorate(std::move(value));
+  }
+
+public:
+  /// <summary>
+  /// Attaches recorded decorations of type T to replayed packets
+  /// </summary>
+  template<class T>
+  void Replay(void) {
+    m_decoders[autowiring::demangle(auto_id_t<T>{})] = &Decode<T>;
+  }
+
+  /// <returns>The number of complete packets in the recording</returns>
+  size_t GetPacketCount(void) const { return m_packets.size(); }
+
+  /// <summary>
+  /// Issues every recorded packet from the specified factory, attaching its recorded decorations
+  /// </summary>
+  /// <returns>The number of packets issued</returns>
+  /// <remarks>
+  /// Each packet is released before the next one is issued
+  /// </remarks>
+  size_t Run(AutoPacketFactory& factory, Pacing pacing = Pacing::Unpaced);
+};
@@ -0,0 +1,184 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "AutoPacketTracer.h"
+#include "AutoPacket.h"
+#include "demangle.h"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+AutoPacketTracer::AutoPacketTracer(size_t sampleEvery, size_t eventsPerThread) :
+  m_sampleEvery(sampleEvery ? sampleEvery : 1),
+  m_eventsPerThread(eventsPerThread ? eventsPerThread : 1),
+  m_epoch(std::chrono::steady_clock::now()),
+  m_localRing([](void*) {})
+{}
+
+AutoPacketTracer::~AutoPacketTracer(void) {}
+
+AutoPacketTracer::Ring& AutoPacketTracer::GetLocalRing(void) {
+  Ring* ring = m_localRing.get();
+  if (ring)
+    return *ring;
+
+  std::lock_guard<std::mutex> lk(m_lock);
+  m_rings.push_back(std::make_shared<Ring>(m_eventsPerThread, m_rings.size()));
+  ring = m_rings.back().get();
+  m_localRing.reset(ring);
+  return *ring;
+}
+
+void AutoPacketTracer::Record(AutoPacketTraceEvent::Kind kind, uint64_t packet, auto_id type) {
+  Ring& ring = GetLocalRing();
+  uint64_t head = ring.head.load(std::memory_order_relaxed);
+  auto ts = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch);
+
+  // Mark the slot as being written before any of its fields change
+  Slot& slot = ring.slots[head % ring.slots.size()];
+  slot.seq.store(2 * head + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.kind.store(static_cast<uint8_t>(kind), std::memory_order_relaxed);
+  slot.packet.store(packet, std::memory_order_relaxed);
+  slot.type.store(type.block, std::memory_order_relaxed);
+  slot.ts.store(static_cast<int64_t>(ts.count()), std::memory_order_relaxed);
+  slot.seq.store(2 * head + 2, std::memory_order_release);
+  ring.head.store(head + 1, std::memory_order_release);
+}
+
+std::vector<std::shared_ptr<AutoPacketTracer::Ring>> AutoPacketTracer::GetRings(void) {
+  std::lock_guard<std::mutex> lk(m_lock);
+  return m_rings;
+}
+
+std::vector<AutoPacketTraceEvent> AutoPacketTracer::CopyEvents(const Ring& ring) {
+  const uint64_t capacity = ring.slots.size();
+  uint64_t head = ring.head.load(std::memory_order_acquire);
+  uint64_t tail = head > capacity ? head - capacity : 0;
+
+  std::vector<AutoPacketTraceEvent> retVal;
+  retVal.reserve(static_cast<size_t>(head - tail));
+  for (uint64_t i = tail; i < head; i++) {
+    const Slot& slot = ring.slots[i % capacity];
+
+    // Skip the slot if the owning thread has lapped us and is writing, or has written, a later event
+    uint64_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq != 2 * i + 2)
+      continue;
+
+    AutoPacketTraceEvent evt;
+    evt.kind = static_cast<AutoPacketTraceEvent::Kind>(slot.kind.load(std::memory_order_relaxed));
+    evt.packet = slot.packet.load(std::memory_order_relaxed);
+    evt.type = auto_id(*slot.type.load(std::memory_order_relaxed));
+    evt.ts = std::chrono::nanoseconds(slot.ts.load(std::memory_order_relaxed));
+
+    // The fields are only consistent if the slot was not rewritten while they were being read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != seq)
+      continue;
+    retVal.push_back(evt);
+  }
+  return retVal;
+}
+
+std::vector<AutoPacketTraceEvent> AutoPacketTracer::GetEvents(void) {
+  std::vector<AutoPacketTraceEvent> retVal;
+  for (auto& ring : GetRings()) {
+    auto events = CopyEvents(*ring);
+    retVal.insert(retVal.end(), events.begin(), events.end());
+  }
+
+  std::stable_sort(
+    retVal.begin(),
+    retVal.end(),
+    [] (const AutoPacketTraceEvent& lhs, const AutoPacketTraceEvent& rhs) {
+      return lhs.ts < rhs.ts;
+    }
+  );
+  return retVal;
+}
+
+void AutoPacketTracer::WriteTrace(std::ostream& os) {
+  auto fill = os.fill();
+  os << "{\"traceEvents\":[";
+  bool first = true;
+  auto write = [&] (const AutoPacketTraceEvent& evt, size_t tid) {
+    const char* ph;
+    const char* cat;
+    std::string name;
+    switch (evt.kind) {
+    case AutoPacketTraceEvent::Kind::PacketBegin:
+      ph = "b";
+      cat = "packet";
+      name = "packet";
+      break;
+    case AutoPacketTraceEvent::Kind::PacketEnd:
+      ph = "e";
+      cat = "packet";
+      name = "packet";
+      break;
+    case AutoPacketTraceEvent::Kind::Decorate:
+      ph = "i";
+      cat = "decorate";
+      name = autowiring::demangle(evt.type);
+      break;
+    case AutoPacketTraceEvent::Kind::Unsatisfiable:
+      ph = "i";
+      cat = "unsatisfiable";
+      name = autowiring::demangle(evt.type);
+      break;
+    case AutoPacketTraceEvent::Kind::FilterBegin:
+      ph = "B";
+      cat = "filter";
+      name = autowiring::demangle(evt.type);
+      break;
+    case AutoPacketTraceEvent::Kind::FilterEnd:
+      ph = "E";
+      cat = "filter";
+      name = autowiring::demangle(evt.type);
+      break;
+    case AutoPacketTraceEvent::Kind::Successor:
+    default:
+      ph = "i";
+      cat = "successor";
+      name = "successor";
+      break;
+    }
+
+    // Type names may contain quotes only in pathological cases, but they must not break the output
+    std::replace(name.begin(), name.end(), '"', '\'');
+
+    os << (first ? "\n" : ",\n")
+       << "{\"name\":\"" << name << "\",\"cat\":\"" << cat << "\",\"ph\":\"" << ph << "\""
+       << ",\"ts\":" << evt.ts.count() / 1000 << '.' << std::setw(3) << std::setfill('0') << evt.ts.count() % 1000
+       << ",\"pid\":1,\"tid\":" << tid;
+    if (*ph == 'i')
+      os << ",\"s\":\"t\"";
+    if (*ph == 'b' || *ph == 'e')
+      os << ",\"id\":" << evt.packet;
+    os << ",\"args\":{\"packet\":" << evt.packet << "}}";
+    first = false;
+  };
+
+  // Each event must be attributed to the thread that recorded it, so events are written ring-by-ring
+  for (auto& ring : GetRings())
+    for (auto& evt : CopyEvents(*ring))
+      write(evt, ring->tid);
+  os << "\n]}" << std::endl;
+  os.fill(fill);
+}
+
+void AutoPacketTracer::AutoFilter(AutoPacket& packet) {
+  if (m_nSeen++ % m_sampleEvery)
+    return;
+
+  uint64_t id = ++m_nTraced;
+  packet.m_traceId = id;
+  packet.m_tracer.store(this, std::memory_order_release);
+  Record(AutoPacketTraceEvent::Kind::PacketBegin, id);
+
+  // The end of the packet is observed the same way AutoPacketGraph observes deliveries
+  packet.AddTeardownListener([this, id] {
+    Record(AutoPacketTraceEvent::Kind::PacketEnd, id);
+  });
+}
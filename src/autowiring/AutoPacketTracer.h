@@ -0,0 +1,150 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "altitude.h"
+#include "auto_id.h"
+#include "thread_specific_ptr.h"
+#include <atomic>
+#include CHRONO_HEADER
+#include <cstdint>
+#include <iosfwd>
+#include MEMORY_HEADER
+#include MUTEX_HEADER
+#include <vector>
+
+class AutoPacket;
+
+/// <summary>
+/// A single timestamped event recorded on a traced packet
+/// </summary>
+struct AutoPacketTraceEvent {
+  enum class Kind : uint8_t {
+    // The packet was issued, or destroyed
+    PacketBegin,
+    PacketEnd,
+
+    // A decoration of the indicated type was attached
+    Decorate,
+
+    // A decoration of the indicated type was marked unsatisfiable
+    Unsatisfiable,
+
+    // An AutoFilter of the indicated type was entered, or returned
+    FilterBegin,
+    FilterEnd,
+
+    // The packet's successor was obtained
+    Successor
+  };
+
+  Kind kind;
+
+  // The identifier assigned to the packet by the tracer
+  uint64_t packet;
+
+  // The decoration or filter type, where applicable
+  auto_id type;
+
+  // Time of the event, relative to the creation of the tracer
+  std::chrono::nanoseconds ts;
+};
+
+/// <summary>
+/// Records a timeline of events on sampled packets, exportable in the Chrome trace-event format
+/// </summary>
+/// <remarks>
+/// Add this type to a context with an AutoPacketFactory to begin tracing.  Like AutoPacketGraph, the
+/// tracer observes every packet through an AutoFilter on AutoPacket&; one in every N packets is then
+/// marked for tracing, and all decorations, filter calls, unsatisfiable markings and successor handoffs
+/// on that packet are recorded from that point on.  Packets which are not sampled pay only the cost of
+/// a null pointer check at each of these points.
+///
+/// Events are recorded without locking into a fixed-size ring buffer belonging to the recording
+/// thread.  When a buffer is full, its oldest events are overwritten.  The resulting trace may be
+/// loaded in about:tracing or Perfetto, where each filter call appears on the thread that ran it.
+/// </remarks>
+class AutoPacketTracer {
+public:
+  /// <param name="sampleEvery">Trace one packet out of this many</param>
+  /// <param name="eventsPerThread">The capacity of the ring buffer of each recording thread</param>
+  AutoPacketTracer(size_t sampleEvery = 1, size_t eventsPerThread = 4096);
+  ~AutoPacketTracer(void);
+
+  // Instrumentation needs to see packets before anyone else does
+  static const autowiring::altitude altitude = autowiring::altitude::Highest;
+
+private:
+  // A single entry in a ring buffer, published as a seqlock.  The sequence number of the entry for
+  // the i-th event recorded on a ring is odd while that event is being written and 2 * (i + 1) once
+  // it is complete.  The fields are atomic so that a reader racing with the writer is well defined;
+  // the reader then uses the sequence number to discard what it read.
+  struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint8_t> kind{0};
+    std::atomic<uint64_t> packet{0};
+    std::atomic<const autowiring::auto_id_block*> type{nullptr};
+    std::atomic<int64_t> ts{0};
+  };
+
+  // Events recorded by a single thread.  Only the owning thread writes, the write position is
+  // published with a release store and each slot is published through its own sequence number.
+  struct Ring {
+    Ring(size_t capacity, size_t tid) :
+      slots(capacity),
+      tid(tid)
+    {}
+
+    std::vector<Slot> slots;
+    std::atomic<uint64_t> head{0};
+    const size_t tid;
+  };
+
+  const size_t m_sampleEvery;
+  const size_t m_eventsPerThread;
+  const std::chrono::steady_clock::time_point m_epoch;
+
+  // Number of packets seen, and number of packets traced
+  std::atomic<uint64_t> m_nSeen{0};
+  std::atomic<uint64_t> m_nTraced{0};
+
+  // All buffers ever registered, guarded by m_lock.  Buffers outlive their threads so that events
+  // can still be exported.
+  std::mutex m_lock;
+  std::vector<std::shared_ptr<Ring>> m_rings;
+
+  // The buffer belonging to the current thread
+  autowiring::thread_specific_ptr<Ring> m_localRing;
+
+  /// <returns>The ring buffer for the current thread, created on first use</returns>
+  Ring& GetLocalRing(void);
+
+  /// <returns>A copy of the collection of all ring buffers</returns>
+  std::vector<std::shared_ptr<Ring>> GetRings(void);
+
+  /// <returns>The events held in the specified ring, oldest first</returns>
+  static std::vector<AutoPacketTraceEvent> CopyEvents(const Ring& ring);
+
+public:
+  /// <summary>
+  /// Records a single event on the specified packet
+  /// </summary>
+  /// <remarks>
+  /// Called by AutoPacket on packets which this tracer has marked for tracing
+  /// </remarks>
+  void Record(AutoPacketTraceEvent::Kind kind, uint64_t packet, auto_id type = auto_id{});
+
+  /// <returns>The number of packets that have been marked for tracing</returns>
+  uint64_t GetTracedPacketCount(void) const { return m_nTraced; }
+
+  /// <returns>A copy of all events currently held in the ring buffers, ordered by time</returns>
+  std::vector<AutoPacketTraceEvent> GetEvents(void);
+
+  /// <summary>
+  /// Writes all recorded events to the specified stream in the Chrome trace-event JSON format
+  /// </summary>
+  void WriteTrace(std::ostream& os);
+
+  /// <summary>
+  /// Marks sampled packets for tracing
+  /// </summary>
+  void AutoFilter(AutoPacket& packet);
+};
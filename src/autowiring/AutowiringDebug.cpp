@@ -11,6 +11,7 @@
 #include <unordered_set>
 #include <sstream>
 #include <thread>
+#include <tuple>
 
 using namespace autowiring;
 using namespace autowiring::dbg;
@@ -389,6 +390,145 @@ void autowiring::dbg::WriteAutoFilterGraph(std::ostream& os, CoreContext& ctxt)
   }
 }
 
+static const char* PhaseName(StartupPhase phase) {
+  switch (phase) {
+  case StartupPhase::Construct:
+    return "construct";
+  case StartupPhase::AutoInit:
+    return "autoinit";
+  case StartupPhase::ResolveSlots:
+    return "resolve";
+  case StartupPhase::NotifyBolts:
+    return "bolts";
+  case StartupPhase::StartRunnable:
+    return "start";
+  }
+  return "unknown";
+}
+
+bool StartupProfiler::Key::operator<(const Key& rhs) const {
+  return
+    std::make_tuple(sigil.block, phase, type.block) <
+    std::make_tuple(rhs.sigil.block, rhs.phase, rhs.type.block);
+}
+
+StartupProfiler::StartupProfiler(uint64_t(*allocationCounter)(void)) :
+  m_allocationCounter(allocationCounter)
+{}
+
+void StartupProfiler::Enter(const CoreContext& ctxt, StartupPhase phase, auto_id type) {
+  uint64_t allocations = Allocations();
+  std::lock_guard<std::mutex> lk(m_lock);
+  ThreadState& state = m_threads[std::this_thread::get_id()];
+  state.frames.push_back(Frame{&ctxt, Key{ctxt.GetSigilType(), phase, type}});
+
+  // Allocations made to record the frame are not attributed to the frame's parent
+  Frame& frame = state.frames.back();
+  frame.allocations = Allocations();
+  state.overhead += frame.allocations - allocations;
+  frame.overhead = state.overhead;
+  frame.nested = std::chrono::nanoseconds{0};
+  frame.start = std::chrono::steady_clock::now();
+}
+
+void StartupProfiler::Leave(void) {
+  auto end = std::chrono::steady_clock::now();
+  uint64_t allocations = Allocations();
+
+  std::lock_guard<std::mutex> lk(m_lock);
+  auto q = m_threads.find(std::this_thread::get_id());
+  if (q == m_threads.end() || q->second.frames.empty())
+    return;
+  ThreadState& state = q->second;
+
+  const Frame frame = state.frames.back();
+  state.frames.pop_back();
+
+  auto total = std::chrono::duration_cast<std::chrono::nanoseconds>(end - frame.start);
+  auto self = total - frame.nested;
+  Stats& stats = m_entries[frame.key];
+  stats.count++;
+  stats.total += total;
+  stats.self += self;
+  stats.allocations += (allocations - frame.allocations) - (state.overhead - frame.overhead);
+
+  // Stack of this frame and all of its parents, marking each frame whose context differs from its parent's
+  std::vector<std::pair<Key, bool>> stack;
+  for (size_t i = 0; i <= state.frames.size(); i++) {
+    const Frame& cur = i < state.frames.size() ? state.frames[i] : frame;
+    stack.push_back({cur.key, !i || state.frames[i - 1].pCtxt != cur.pCtxt});
+  }
+  m_stacks[std::move(stack)] += self;
+
+  if (state.frames.empty())
+    m_threads.erase(q);
+  else {
+    state.frames.back().nested += total;
+    state.overhead += Allocations() - allocations;
+  }
+}
+
+std::vector<StartupProfileEntry> StartupProfiler::GetReport(void) const {
+  std::vector<StartupProfileEntry> retVal;
+  {
+    std::lock_guard<std::mutex> lk(m_lock);
+    for (const auto& entry : m_entries)
+      retVal.push_back({
+        DemangleWithAutoID(entry.first.sigil),
+        entry.first.phase,
+        DemangleWithAutoID(entry.first.type),
+        entry.second.count,
+        entry.second.total,
+        entry.second.self,
+        entry.second.allocations
+      });
+  }
+
+  std::stable_sort(
+    retVal.begin(),
+    retVal.end(),
+    [](const StartupProfileEntry& lhs, const StartupProfileEntry& rhs) { return lhs.self > rhs.self; }
+  );
+  return retVal;
+}
+
+void StartupProfiler::WriteReport(std::ostream& os) const {
+  os << std::setw(12) << "self (us)"
+     << std::setw(12) << "total (us)"
+     << std::setw(8) << "count"
+     << std::setw(10) << "allocs"
+     << "  phase" << std::endl;
+
+  for (const auto& entry : GetReport())
+    os << std::setw(12) << std::chrono::duration_cast<std::chrono::microseconds>(entry.self).count()
+       << std::setw(12) << std::chrono::duration_cast<std::chrono::microseconds>(entry.total).count()
+       << std::setw(8) << entry.count
+       << std::setw(10) << entry.allocations
+       << "  " << PhaseName(entry.phase) << ' ' << entry.type
+       << " in " << entry.context << std::endl;
+}
+
+void StartupProfiler::WriteFoldedStacks(std::ostream& os) const {
+  std::lock_guard<std::mutex> lk(m_lock);
+  for (const auto& stack : m_stacks) {
+    const char* delim = "";
+    for (const auto& frame : stack.first) {
+      os << delim;
+      if (frame.second)
+        os << "context " << DemangleWithAutoID(frame.first.sigil) << ';';
+      os << PhaseName(frame.first.phase) << ' ' << DemangleWithAutoID(frame.first.type);
+      delim = ";";
+    }
+    os << ' ' << stack.second.count() << std::endl;
+  }
+}
+
+std::shared_ptr<StartupProfiler> autowiring::dbg::ProfileStartup(CoreContext& ctxt, uint64_t(*allocationCounter)(void)) {
+  auto retVal = std::make_shared<StartupProfiler>(allocationCounter);
+  ctxt.SetProfiler(retVal);
+  return retVal;
+}
+
 void autowiring::dbg::DebugInit(void) {
   static const void* p [] = {
     (void*) AutoFilterGraphStr
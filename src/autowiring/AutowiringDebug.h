@@ -1,9 +1,16 @@
 // Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
 #pragma once
+#include "ContextProfiler.h"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
-#include <ostream>
-#include <memory>
 
 class AutoPacket;
 class CoreContext;
@@ -71,6 +78,121 @@ namespace autowiring {
     void WriteAutoFilterGraph(std::ostream& os, const std::shared_ptr<CoreContext>& ctxt);
     void WriteAutoFilterGraph(std::ostream& os, CoreContext& ctxt);
 
+    /// <summary>
+    /// The time and allocations attributed to one phase of startup for one type, in contexts of one sigil
+    /// </summary>
+    struct StartupProfileEntry {
+      // Sigil of the context where the phase took place
+      std::string context;
+
+      // The phase, and the member type or sigil type to which it pertains
+      StartupPhase phase;
+      std::string type;
+
+      // The number of times this phase took place
+      size_t count;
+
+      // Time spent in the phase, including and excluding the phases nested within it
+      std::chrono::nanoseconds total;
+      std::chrono::nanoseconds self;
+
+      // Allocations made during the phase including nested phases, zero if allocations are not counted
+      uint64_t allocations;
+    };
+
+    /// <summary>
+    /// A ContextProfiler that measures where time is spent while contexts are populated and started
+    /// </summary>
+    /// <remarks>
+    /// Phases are aggregated by the sigil of their context, the phase, and the type to which the phase
+    /// pertains, so the members of many contexts with the same sigil are reported together.
+    /// </remarks>
+    class StartupProfiler:
+      public ContextProfiler
+    {
+    public:
+      /// <param name="allocationCounter">
+      /// Optional, returns the number of allocations the process has made so far.  Autowiring does not
+      /// count allocations itself; an application that replaces the global operator new may supply one.
+      /// The count is process-wide, so allocations made by other threads during a phase are included.
+      /// </param>
+      StartupProfiler(uint64_t(*allocationCounter)(void) = nullptr);
+
+      // ContextProfiler overrides:
+      void Enter(const CoreContext& ctxt, StartupPhase phase, auto_id type) override;
+      void Leave(void) override;
+
+      /// <returns>Every recorded entry, in descending order of self time</returns>
+      std::vector<StartupProfileEntry> GetReport(void) const;
+
+      /// <summary>
+      /// Writes the report as a table, in descending order of self time
+      /// </summary>
+      void WriteReport(std::ostream& os) const;
+
+      /// <summary>
+      /// Writes each distinct stack of nested phases with its self time in nanoseconds
+      /// </summary>
+      /// <remarks>
+      /// The output is in the folded stack format consumed by flamegraph.pl.  A frame naming the
+      /// context is inserted wherever a phase takes place in a different context than its parent.
+      /// </remarks>
+      void WriteFoldedStacks(std::ostream& os) const;
+
+    private:
+      struct Key {
+        auto_id sigil;
+        StartupPhase phase;
+        auto_id type;
+
+        bool operator<(const Key& rhs) const;
+      };
+
+      struct Stats {
+        size_t count = 0;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds self{0};
+        uint64_t allocations = 0;
+      };
+
+      struct Frame {
+        const CoreContext* pCtxt;
+        Key key;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::nanoseconds nested;
+        uint64_t allocations;
+        uint64_t overhead;
+      };
+
+      struct ThreadState {
+        std::vector<Frame> frames;
+
+        // Allocations made by this profiler on this thread, which are not attributed to any phase
+        uint64_t overhead = 0;
+      };
+
+      uint64_t (*const m_allocationCounter)(void);
+
+      mutable std::mutex m_lock;
+      std::unordered_map<std::thread::id, ThreadState> m_threads;
+      std::map<Key, Stats> m_entries;
+
+      // Keyed by the stack of phases, with the context of each phase for folded stack output
+      std::map<std::vector<std::pair<Key, bool>>, std::chrono::nanoseconds> m_stacks;
+
+      uint64_t Allocations(void) const { return m_allocationCounter ? m_allocationCounter() : 0; }
+    };
+
+    /// <summary>
+    /// Attaches a new StartupProfiler to the specified context
+    /// </summary>
+    /// <returns>The attached profiler</returns>
+    /// <remarks>
+    /// Contexts subsequently created as children of the context are also profiled.  Call this before
+    /// adding members to the context.
+    /// </remarks>
+    std::shared_ptr<StartupProfiler> ProfileStartup(CoreContext& ctxt, uint64_t(*allocationCounter)(void) = nullptr);
+
     /// <summary>
     /// Initializes the Autowiring debug library
     /// </summary>
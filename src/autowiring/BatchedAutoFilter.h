@@ -0,0 +1,176 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "AutoPacket.h"
+#include "CoreThread.h"
+#include CHRONO_HEADER
+#include MEMORY_HEADER
+#include MUTEX_HEADER
+#include <vector>
+
+namespace autowiring {
+
+/// <summary>
+/// A run of packets collected for batch processing, together with the decoration of type T on each
+/// </summary>
+/// <remarks>
+/// Entries appear in the order in which their decorations became available.  The batch keeps each of
+/// its packets alive, so batch filters may attach further decorations to the packets it references.
+/// </remarks>
+template<class T>
+class batch {
+public:
+  batch(const std::shared_ptr<AutoPacket>* packets, const std::shared_ptr<const T>* values, size_t n) :
+    m_packets(packets),
+    m_values(values),
+    m_n(n)
+  {}
+
+private:
+  const std::shared_ptr<AutoPacket>* const m_packets;
+  const std::shared_ptr<const T>* const m_values;
+  const size_t m_n;
+
+public:
+  size_t size(void) const { return m_n; }
+  bool empty(void) const { return !m_n; }
+
+  /// <returns>The decoration of type T on the i'th packet of the batch</returns>
+  const T& operator[](size_t i) const { return *m_values[i]; }
+
+  /// <returns>The i'th packet of the batch</returns>
+  AutoPacket& packet(size_t i) const { return *m_packets[i]; }
+
+  /// <returns>The shared pointers to all decorations in this batch, contiguous in memory</returns>
+  const std::shared_ptr<const T>* values(void) const { return m_values; }
+
+  /// <returns>The shared pointers to all packets in this batch, contiguous in memory</returns>
+  const std::shared_ptr<AutoPacket>* packets(void) const { return m_packets; }
+};
+
+}
+
+/// <summary>
+/// Base type for filters which process a decoration of type T over many packets in a single call
+/// </summary>
+/// <remarks>
+/// Filters deriving from this type implement AutoFilterBatch in place of AutoFilter.  When a packet is
+/// decorated with T, the packet is appended to a pending batch; the batch is handed to AutoFilterBatch
+/// on this object's thread as soon as it reaches the configured batch size, or once the first packet
+/// in the batch has waited for the configured latency budget, whichever comes first.  This amortizes
+/// per-call overhead across many packets and allows the filter to operate on all of them at once.
+///
+/// Decorations attached with DecorateImmediate are not eligible for batching, because they do not
+/// outlive the call that attached them.
+/// </remarks>
+template<class T>
+class BatchedAutoFilter:
+  public CoreThread
+{
+public:
+  /// <param name="batchSize">The number of packets to be collected before a batch is processed</param>
+  /// <param name="latency">The longest time a packet may wait for its batch to fill</param>
+  BatchedAutoFilter(size_t batchSize = 64, std::chrono::microseconds latency = std::chrono::milliseconds(1), const char* pName = "BatchedAutoFilter") :
+    CoreThread(pName),
+    m_batchSize(batchSize ? batchSize : 1),
+    m_latency(latency)
+  {}
+
+private:
+  const size_t m_batchSize;
+  const std::chrono::microseconds m_latency;
+
+  // Parallel arrays of the packets and decorations in a batch
+  struct Pending {
+    std::vector<std::shared_ptr<AutoPacket>> packets;
+    std::vector<std::shared_ptr<const T>> values;
+  };
+
+  // Guards the pending batch:
+  std::mutex m_batchLock;
+
+  // The batch being filled, or nullptr if no packets are waiting
+  std::shared_ptr<Pending> m_pending;
+
+  // Incremented each time a batch is taken, used to discard stale latency timers
+  uint64_t m_generation = 0;
+
+  /// <summary>
+  /// Takes the pending batch, if it is still the batch from the specified generation
+  /// </summary>
+  std::shared_ptr<Pending> TakeUnsafe(uint64_t generation) {
+    if (generation != m_generation)
+      return nullptr;
+    m_generation++;
+    return std::move(m_pending);
+  }
+
+  void Process(const std::shared_ptr<Pending>& pending) {
+    if (pending)
+      AutoFilterBatch(autowiring::batch<T>{pending->packets.data(), pending->values.data(), pending->values.size()});
+  }
+
+public:
+  /// <summary>
+  /// Processes any pending batch immediately on the calling thread
+  /// </summary>
+  void Flush(void) {
+    std::shared_ptr<Pending> pending;
+    {
+      std::lock_guard<std::mutex> lk(m_batchLock);
+      pending = TakeUnsafe(m_generation);
+    }
+    Process(pending);
+  }
+
+  /// <summary>
+  /// Collects the packet into the pending batch
+  /// </summary>
+  void AutoFilter(AutoPacket& packet, const std::shared_ptr<const T>& value) {
+    if (!value)
+      // Unsatisfiable on this packet, nothing to collect
+      return;
+
+    std::shared_ptr<Pending> full;
+    bool isFirst = false;
+    uint64_t generation;
+    {
+      std::lock_guard<std::mutex> lk(m_batchLock);
+      if (!m_pending) {
+        m_pending = std::make_shared<Pending>();
+        m_pending->packets.reserve(m_batchSize);
+        m_pending->values.reserve(m_batchSize);
+        isFirst = true;
+      }
+      m_pending->packets.push_back(packet.shared_from_this());
+      m_pending->values.push_back(value);
+
+      generation = m_generation;
+      if (m_pending->values.size() >= m_batchSize)
+        full = TakeUnsafe(generation);
+    }
+
+    if (full)
+      *this += [this, full] { Process(full); };
+    else if (isFirst)
+      // Start the latency clock for this batch
+      *this += m_latency, [this, generation] {
+        std::shared_ptr<Pending> pending;
+        {
+          std::lock_guard<std::mutex> lk(m_batchLock);
+          pending = TakeUnsafe(generation);
+        }
+        Process(pending);
+      };
+  }
+
+  /// <summary>
+  /// Invoked on this object's thread with each completed batch
+  /// </summary>
+  virtual void AutoFilterBatch(const autowiring::batch<T>& batch) = 0;
+
+  // CoreThread overrides:
+  void OnStop(void) override {
+    // Graceful termination will process whatever is left over
+    *this += [this] { Flush(); };
+  }
+};
@@ -16,6 +16,83 @@ namespace autowiring {
 // The type of the call centralizer
 typedef void(*t_extractedCall)(const void* obj, AutoPacket&);
 
+/// <summary>
+/// True if the argument is a plain read of a single decoration, which may be resolved by DispositionCache
+/// </summary>
+template<class Arg>
+struct is_cached_arg {
+  static const bool value =
+    auto_arg<Arg>::is_input &&
+    !auto_arg<Arg>::is_rvalue &&
+    !auto_arg<Arg>::is_multi;
+};
+
+/// <summary>
+/// The decoration dispositions of all inputs to a single AutoFilter call
+/// </summary>
+/// <remarks>
+/// All dispositions are looked up under one acquisition of the packet lock when the cache is
+/// constructed.  Arguments are then extracted from the resolved dispositions without any further
+/// locking, presenting the same Get interface as AutoPacket so that it may be passed to auto_arg.
+/// </remarks>
+template<size_t N>
+class DispositionCache {
+public:
+  DispositionCache(const AutoPacket& packet, const DecorationKey (&keys)[N]) :
+    packet(packet),
+    keys(keys)
+  {
+    packet.GetDispositions(keys, dispositions, N);
+  }
+
+private:
+  const AutoPacket& packet;
+  const DecorationKey (&keys)[N];
+  const DecorationDisposition* dispositions[N];
+
+  const DecorationDisposition* Find(const DecorationKey& key) const {
+    for (size_t i = 0; i < N; i++)
+      if (keys[i] == key)
+        return dispositions[i];
+
+    // Not one of the keys we resolved, use the ordinary locked lookup
+    return packet.GetDisposition(key);
+  }
+
+public:
+  template<class T>
+  const T& Get(int tshift = 0) const {
+    const T* retVal;
+    if (!Get(retVal, tshift) || !retVal)
+      AutoPacket::ThrowNotDecoratedException(DecorationKey(auto_id_t<T>{}, tshift));
+    return *retVal;
+  }
+
+  template<class T>
+  bool Get(const T*& out, int tshift = 0) const {
+    DecorationKey key(auto_id_t<T>{}, tshift);
+    return AutoPacket::GetFrom(Find(key), key, out);
+  }
+
+  template<class T>
+  const std::shared_ptr<const T>* GetShared(int tshift = 0) const {
+    typedef typename std::remove_const<T>::type TActual;
+    DecorationKey key(auto_id_t<TActual>{}, tshift);
+
+    const std::shared_ptr<const T>* retVal;
+    AutoPacket::GetFrom(Find(key), key, retVal);
+    return retVal;
+  }
+};
+
+// Zero-argument specialization, nothing to resolve
+template<>
+class DispositionCache<0> {
+public:
+  template<class Keys>
+  DispositionCache(const AutoPacket&, const Keys&) {}
+};
+
 /// <summary>
 /// An argument pack that holds all of the inputs and outputs to an AutoFilter during its invocation
 /// </summary>
@@ -25,13 +102,40 @@ struct CESetup {
   CESetup(AutoPacket& packet) :
     packet(packet),
     pshr(packet.GetContext()),
-    args(auto_arg<Args>::arg(packet)...)
+    keys{ KeyOf<Args>()... },
+    inputs(packet, keys),
+    args(Extract<Args>(packet, inputs)...)
   {}
 
   AutoPacket& packet;
   CurrentContextPusher pshr;
+
+  // Keys of the inputs which are resolved together, other arguments have a negative time shift
+  DecorationKey keys[sizeof...(Args)];
+  DispositionCache<sizeof...(Args)> inputs;
+
   autowiring::tuple<typename auto_arg<Args>::type...> args;
 
+  template<class Arg>
+  static DecorationKey KeyOf(typename std::enable_if<is_cached_arg<Arg>::value>::type* = nullptr) {
+    return DecorationKey(typename auto_arg<Arg>::id_type{}, auto_arg<Arg>::tshift);
+  }
+
+  template<class Arg>
+  static DecorationKey KeyOf(typename std::enable_if<!is_cached_arg<Arg>::value>::type* = nullptr) {
+    return DecorationKey{};
+  }
+
+  template<class Arg>
+  static typename auto_arg<Arg>::type Extract(AutoPacket&, const DispositionCache<sizeof...(Args)>& inputs, typename std::enable_if<is_cached_arg<Arg>::value>::type* = nullptr) {
+    return auto_arg<Arg>::arg(inputs);
+  }
+
+  template<class Arg>
+  static typename auto_arg<Arg>::type Extract(AutoPacket& packet, const DispositionCache<sizeof...(Args)>&, typename std::enable_if<!is_cached_arg<Arg>::value>::type* = nullptr) {
+    return auto_arg<Arg>::arg(packet);
+  }
+
   template<int N>
   typename std::enable_if<
     auto_arg<typename autowiring::nth_type<N, Args...>::type>::is_output,
@@ -152,6 +256,9 @@ struct CE<Deferred(T::*)(Args...), index_tuple<N...>> :
 
     // Pend the call to this object's dispatch queue:
     *(T*) pObj += [pObj, pAutoPacket] {
+      // The packet's deadline may have passed while this call was pending
+      if (pAutoPacket->SkipIfPastDeadline(pObj, &Call<memFn>))
+        return;
 
       // Extract, call, commit
       t_ceSetup extractor(*pAutoPacket);
@@ -0,0 +1,422 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "autowiring_error.h"
+#include "CoreContext.h"
+#include <atomic>
+#include FUNCTIONAL_HEADER
+#include MEMORY_HEADER
+#include MUTEX_HEADER
+#include THREAD_HEADER
+#include <utility>
+#include <vector>
+
+/// <summary>
+/// A hashed variant of ContextMap for maps that are read far more often than they are changed
+/// </summary>
+/// <remarks>
+/// Keys are partitioned among a fixed number of shards, each with its own writer lock, so writers on
+/// different shards do not contend.  Find and Enumerate do not take any lock.  Readers announce
+/// themselves on a pair of per-shard counters, and a writer that unlinks an entry waits for the
+/// readers which might still see that entry before deleting it.
+///
+/// Entries are not evicted when their contexts expire.  Instead, the teardown of a context marks its
+/// shard, and once expired entries make up half of a shard, the teardown starts a background thread
+/// which sweeps them out.  A later Add to the shard, growing the shard, or a call to Sweep also evicts
+/// them.  Until then, Find returns nullptr for an expired entry, and size counts it.
+///
+/// All members are thread safe.  Key must be equality comparable and hashable with Hash.
+/// </remarks>
+template<class Key, class Hash = std::hash<Key>>
+class ConcurrentContextMap
+{
+public:
+  /// <param name="nShards">The number of shards, rounded up to a power of two</param>
+  explicit ConcurrentContextMap(size_t nShards = 16) :
+    m_state(std::make_shared<State>(nShards))
+  {}
+
+  ConcurrentContextMap(const ConcurrentContextMap&) = delete;
+  ConcurrentContextMap& operator=(const ConcurrentContextMap&) = delete;
+
+private:
+  struct Node {
+    Node(const Key& key, size_t hash, std::weak_ptr<CoreContext> context) :
+      key(key),
+      hash(hash),
+      context(std::move(context)),
+      next(nullptr)
+    {}
+
+    const Key key;
+    const size_t hash;
+    const std::weak_ptr<CoreContext> context;
+    std::atomic<Node*> next;
+  };
+
+  struct Buckets {
+    explicit Buckets(size_t n) :
+      mask(n - 1),
+      heads(new std::atomic<Node*>[n])
+    {
+      for (size_t i = 0; i < n; i++)
+        heads[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~Buckets(void) {
+      for (size_t i = 0; i <= mask; i++)
+        for (Node* node = heads[i].load(std::memory_order_relaxed); node;) {
+          Node* next = node->next.load(std::memory_order_relaxed);
+          delete node;
+          node = next;
+        }
+    }
+
+    const size_t mask;
+    const std::unique_ptr<std::atomic<Node*>[]> heads;
+
+    std::atomic<Node*>& head(size_t slot) { return heads[slot & mask]; }
+  };
+
+  // Nodes and bucket arrays which have been unlinked, but which readers may still be traversing
+  struct Retired {
+    std::vector<Node*> nodes;
+    std::vector<Buckets*> buckets;
+
+    bool empty(void) const { return nodes.empty() && buckets.empty(); }
+
+    ~Retired(void) {
+      for (Node* node : nodes)
+        delete node;
+      for (Buckets* cur : buckets) {
+        // Nodes still linked from a retired array have been moved elsewhere or retired separately
+        for (size_t i = 0; i <= cur->mask; i++)
+          cur->heads[i].store(nullptr, std::memory_order_relaxed);
+        delete cur;
+      }
+    }
+  };
+
+  struct Shard {
+    Shard(void) :
+      buckets(new Buckets(8)),
+      count(0),
+      nExpired(0),
+      sweepPending(false),
+      epoch(0)
+    {
+      readers[0].store(0, std::memory_order_relaxed);
+      readers[1].store(0, std::memory_order_relaxed);
+    }
+
+    ~Shard(void) {
+      delete buckets.load(std::memory_order_relaxed);
+    }
+
+    // Serializes writers
+    std::mutex lock;
+
+    std::atomic<Buckets*> buckets;
+
+    // Number of entries, and a hint of the number of those which have expired
+    std::atomic<size_t> count;
+    std::atomic<size_t> nExpired;
+
+    // Set while a background sweep of this shard has been started but has not yet taken the lock
+    std::atomic<bool> sweepPending;
+
+    // Readers in the shard, counted by the parity of the epoch in which they entered
+    std::atomic<size_t> epoch;
+    std::atomic<size_t> readers[2];
+  };
+
+  struct State {
+    State(size_t nShards) {
+      while ((size_t)1 << shardBits < nShards)
+        shardBits++;
+      shards.reset(new Shard[(size_t)1 << shardBits]);
+    }
+
+    size_t shardBits = 0;
+    std::unique_ptr<Shard[]> shards;
+    Hash hash;
+  };
+
+  // Registers a reader with a shard for the lifetime of the guard
+  class ReadGuard {
+  public:
+    ReadGuard(Shard& shard) {
+      for (;;) {
+        size_t epoch = shard.epoch.load();
+        m_readers = &shard.readers[epoch & 1];
+        ++*m_readers;
+
+        // If a writer advanced the epoch before we were counted, it may not have waited for us
+        if (shard.epoch.load() == epoch)
+          break;
+        --*m_readers;
+      }
+    }
+
+    ~ReadGuard(void) {
+      --*m_readers;
+    }
+
+  private:
+    std::atomic<size_t>* m_readers;
+  };
+
+  const std::shared_ptr<State> m_state;
+
+  // The fewest expired entries for which a background sweep is started
+  static const size_t c_minBackgroundSweep = 8;
+
+  Shard& ShardFor(size_t hash) const {
+    return m_state->shards[hash & (((size_t)1 << m_state->shardBits) - 1)];
+  }
+
+  size_t SlotFor(size_t hash) const {
+    return hash >> m_state->shardBits;
+  }
+
+  /// <summary>
+  /// Waits for every reader which entered the shard before this call to leave it
+  /// </summary>
+  /// <remarks>
+  /// The shard lock must be held.
+  /// </remarks>
+  static void Synchronize(Shard& shard) {
+    size_t epoch = shard.epoch.load();
+    shard.epoch.store(epoch + 1);
+    while (shard.readers[epoch & 1].load())
+      std::this_thread::yield();
+  }
+
+  /// <summary>
+  /// Unlinks every expired entry in the shard
+  /// </summary>
+  /// <remarks>
+  /// The shard lock must be held.
+  /// </remarks>
+  static void SweepUnsafe(Shard& shard, Retired& retired) {
+    shard.nExpired = 0;
+
+    Buckets* buckets = shard.buckets.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= buckets->mask; i++) {
+      std::atomic<Node*>* link = &buckets->heads[i];
+      for (Node* node = link->load(std::memory_order_relaxed); node; node = link->load(std::memory_order_relaxed)) {
+        if (!node->context.expired()) {
+          link = &node->next;
+          continue;
+        }
+
+        link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+        retired.nodes.push_back(node);
+        shard.count--;
+      }
+    }
+  }
+
+  /// <summary>
+  /// Notes the expiration of an entry in the shard, sweeping it in the background if enough have expired
+  /// </summary>
+  static void OnExpired(const std::shared_ptr<State>& state, Shard& shard) {
+    size_t nExpired = ++shard.nExpired;
+    if (nExpired < c_minBackgroundSweep || nExpired <= shard.count / 2 || shard.sweepPending.exchange(true))
+      return;
+
+    // The thread holds the state, so the shard outlives it even if the map is destroyed first
+    std::thread([state, &shard] {
+      Retired retired;
+      std::lock_guard<std::mutex> lk(shard.lock);
+      shard.sweepPending = false;
+      SweepUnsafe(shard, retired);
+      if (!retired.empty())
+        Synchronize(shard);
+    }).detach();
+  }
+
+  /// <summary>
+  /// Moves the live entries of the shard into a bucket array twice the size of the current one
+  /// </summary>
+  /// <remarks>
+  /// The shard lock must be held.  Nodes are copied rather than relinked, so that readers still
+  /// traversing the old array are not diverted into the new one.
+  /// </remarks>
+  void GrowUnsafe(Shard& shard, Retired& retired) const {
+    shard.nExpired = 0;
+
+    Buckets* old = shard.buckets.load(std::memory_order_relaxed);
+    Buckets* grown = new Buckets(2 * (old->mask + 1));
+    size_t count = 0;
+    for (size_t i = 0; i <= old->mask; i++)
+      for (Node* node = old->heads[i].load(std::memory_order_relaxed); node; node = node->next.load(std::memory_order_relaxed)) {
+        retired.nodes.push_back(node);
+        if (node->context.expired())
+          continue;
+
+        Node* copy = new Node(node->key, node->hash, node->context);
+        auto& head = grown->head(SlotFor(node->hash));
+        copy->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        head.store(copy, std::memory_order_relaxed);
+        count++;
+      }
+
+    shard.buckets.store(grown, std::memory_order_release);
+    shard.count = count;
+    retired.buckets.push_back(old);
+  }
+
+public:
+  /// <returns>The number of entries, including expired entries that have not yet been swept</returns>
+  size_t size(void) const {
+    size_t retVal = 0;
+    for (size_t i = (size_t)1 << m_state->shardBits; i--;)
+      retVal += m_state->shards[i].count.load(std::memory_order_relaxed);
+    return retVal;
+  }
+
+  /// <summary>
+  /// Removes all elements from the map
+  /// </summary>
+  void clear(void) {
+    for (size_t i = (size_t)1 << m_state->shardBits; i--;) {
+      Shard& shard = m_state->shards[i];
+      Retired retired;
+      std::lock_guard<std::mutex> lk(shard.lock);
+      Buckets* old = shard.buckets.load(std::memory_order_relaxed);
+      for (size_t j = 0; j <= old->mask; j++)
+        for (Node* node = old->heads[j].load(std::memory_order_relaxed); node; node = node->next.load(std::memory_order_relaxed))
+          retired.nodes.push_back(node);
+      retired.buckets.push_back(old);
+
+      shard.buckets.store(new Buckets(old->mask + 1), std::memory_order_release);
+      shard.count = 0;
+      shard.nExpired = 0;
+      Synchronize(shard);
+    }
+  }
+
+  /// <summary>
+  /// Evicts all entries whose contexts have expired
+  /// </summary>
+  void Sweep(void) {
+    for (size_t i = (size_t)1 << m_state->shardBits; i--;) {
+      Shard& shard = m_state->shards[i];
+      if (!shard.nExpired)
+        continue;
+
+      Retired retired;
+      std::lock_guard<std::mutex> lk(shard.lock);
+      SweepUnsafe(shard, retired);
+      if (!retired.empty())
+        Synchronize(shard);
+    }
+  }
+
+  /// <summary>
+  /// Invokes the passed function on each live entry of the map until it returns false
+  /// </summary>
+  /// <remarks>
+  /// Each shard is copied before its entries are visited, so the function may modify this map.
+  /// Entries added or removed during enumeration might not be seen.
+  /// </remarks>
+  template<class Fn>
+  void Enumerate(Fn&& fn) const {
+    std::vector<std::pair<Key, std::shared_ptr<CoreContext>>> entries;
+    for (size_t i = 0; i < (size_t)1 << m_state->shardBits; i++) {
+      Shard& shard = m_state->shards[i];
+      entries.clear();
+      {
+        ReadGuard guard(shard);
+        Buckets* buckets = shard.buckets.load(std::memory_order_acquire);
+        for (size_t j = 0; j <= buckets->mask; j++)
+          for (Node* node = buckets->heads[j].load(std::memory_order_acquire); node; node = node->next.load(std::memory_order_acquire)) {
+            auto ctxt = node->context.lock();
+            if (ctxt)
+              entries.emplace_back(node->key, std::move(ctxt));
+          }
+      }
+
+      for (auto& entry : entries)
+        if (!fn(entry.first, entry.second))
+          return;
+    }
+  }
+
+  /// <summary>
+  /// Adds a new context to the map
+  /// </summary>
+  /// <remarks>
+  /// The context will be tracked until its reference count hits zero.  This method does not
+  /// alter the reference count of the passed context.
+  ///
+  /// An exception will be thrown if the passed key is already associated with a context
+  /// </remarks>
+  void Add(const Key& key, const std::shared_ptr<CoreContext>& context) {
+    const size_t hash = m_state->hash(key);
+    Shard& shard = ShardFor(hash);
+
+    Retired retired;
+    {
+      std::lock_guard<std::mutex> lk(shard.lock);
+      Buckets* buckets = shard.buckets.load(std::memory_order_relaxed);
+      auto& head = buckets->head(SlotFor(hash));
+
+      // An expired entry for the same key is replaced
+      std::atomic<Node*>* link = &head;
+      for (Node* node = link->load(std::memory_order_relaxed); node; link = &node->next, node = link->load(std::memory_order_relaxed)) {
+        if (node->hash != hash || !(node->key == key))
+          continue;
+        if (!node->context.expired())
+          throw autowiring_error("Specified key is already associated with another context");
+
+        link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+        retired.nodes.push_back(node);
+        shard.count--;
+        break;
+      }
+
+      Node* node = new Node(key, hash, context);
+      node->next.store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      head.store(node, std::memory_order_release);
+      shard.count++;
+
+      if (shard.count > 2 * (buckets->mask + 1))
+        GrowUnsafe(shard, retired);
+      else if (shard.nExpired > shard.count / 2)
+        SweepUnsafe(shard, retired);
+
+      if (!retired.empty())
+        Synchronize(shard);
+    }
+
+    // The teardown notice only marks the shard, eviction is left to a background sweep or a later writer
+    std::weak_ptr<State> state = m_state;
+    context->onTeardown += [state, &shard] (const CoreContext&) {
+      if (auto locked = state.lock())
+        OnExpired(locked, shard);
+    };
+  }
+
+  /// <summary>
+  /// Attempts to find a context by the specified key
+  /// </summary>
+  std::shared_ptr<CoreContext> Find(const Key& key) const {
+    const size_t hash = m_state->hash(key);
+    Shard& shard = ShardFor(hash);
+
+    ReadGuard guard(shard);
+    Buckets* buckets = shard.buckets.load(std::memory_order_acquire);
+    for (Node* node = buckets->head(SlotFor(hash)).load(std::memory_order_acquire); node; node = node->next.load(std::memory_order_acquire))
+      if (node->hash == hash && node->key == key)
+        return node->context.lock();
+    return nullptr;
+  }
+
+  /// <summary>
+  /// Identical to Find
+  /// </summary>
+  std::shared_ptr<CoreContext> operator[](const Key& key) const {
+    return Find(key);
+  }
+};
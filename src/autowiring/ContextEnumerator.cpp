@@ -2,6 +2,9 @@
 #include "stdafx.h"
 #include "ContextEnumerator.h"
 #include "CoreContext.h"
+#include "ForEachConcurrently.h"
+#include <algorithm>
+#include THREAD_HEADER
 
 using namespace autowiring;
 
@@ -70,3 +73,65 @@ CurrentContextEnumerator::CurrentContextEnumerator(void) :
   ContextEnumerator(CoreContext::CurrentContext())
 {
 }
+
+ContextSnapshot::ContextSnapshot(void) :
+  ContextSnapshot(CoreContext::CurrentContext())
+{}
+
+ContextSnapshot::ContextSnapshot(const std::shared_ptr<CoreContext>& root) {
+  if (root)
+    Append(root);
+}
+
+void ContextSnapshot::Append(const std::shared_ptr<CoreContext>& ctxt) {
+  size_t i = m_entries.size();
+  m_entries.push_back({ ctxt, 0 });
+
+  auto children = ctxt->GetChildSnapshot();
+  for (const auto& weak : children->children) {
+    auto child = weak.lock();
+    if (child)
+      Append(child);
+  }
+  m_entries[i].end = m_entries.size();
+}
+
+void ContextSnapshot::Visit(const std::function<void(const std::shared_ptr<CoreContext>&)>& fn) const {
+  for (const auto& entry : m_entries) {
+    auto ctxt = entry.context.lock();
+    if (ctxt)
+      fn(ctxt);
+  }
+}
+
+void ContextSnapshot::Visit(const std::function<void(const std::shared_ptr<CoreContext>&)>& fn, size_t nWorkers) const {
+  if (!nWorkers)
+    nWorkers = std::max(1U, std::thread::hardware_concurrency());
+
+  // Subtrees no larger than the grain are visited whole, larger ones are divided into their root
+  // and the subtrees of its children.  Each range is a half-open interval of entries.
+  const size_t grain = std::max<size_t>(1, m_entries.size() / (4 * nWorkers));
+  std::vector<std::pair<size_t, size_t>> ranges;
+  for (size_t i = 0; i < m_entries.size();) {
+    if (m_entries[i].end - i <= grain) {
+      ranges.emplace_back(i, m_entries[i].end);
+      i = m_entries[i].end;
+    }
+    else {
+      ranges.emplace_back(i, i + 1);
+      i++;
+    }
+  }
+
+  autowiring::ForEachConcurrently(
+    ranges.size(),
+    nWorkers,
+    [&](size_t i) {
+      for (size_t j = ranges[i].first; j < ranges[i].second; j++) {
+        auto ctxt = m_entries[j].context.lock();
+        if (ctxt)
+          fn(ctxt);
+      }
+    }
+  );
+}
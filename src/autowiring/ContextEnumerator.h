@@ -1,7 +1,9 @@
 // Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
 #pragma once
 #include "autowiring_error.h"
+#include FUNCTIONAL_HEADER
 #include MEMORY_HEADER
+#include <vector>
 
 class CoreContext;
 
@@ -176,3 +178,63 @@ public:
   iterator begin(void) { return iterator(m_root, m_root); };
   iterator end(void) { return iterator(m_root); }
 };
+
+/// <summary>
+/// A copy of the tree of contexts rooted at a context, which may be visited without locking any of them
+/// </summary>
+/// <remarks>
+/// The tree is recorded in preorder when the snapshot is taken.  The children of each context are copied in
+/// one step under that context's lock, or without locking at all if they have not changed since they were
+/// last copied, so that taking a snapshot holds up the creation and teardown of contexts for no longer than
+/// one such copy.  ContextEnumerator, by comparison, takes a lock at every step.
+///
+/// The snapshot holds only weak references.  Contexts which are destroyed after the snapshot is taken are
+/// skipped when it is visited, and contexts created afterwards are not visited at all.
+/// </remarks>
+class ContextSnapshot
+{
+public:
+  /// <summary>
+  /// Takes a snapshot of the tree rooted at the current context
+  /// </summary>
+  ContextSnapshot(void);
+
+  /// <summary>
+  /// Takes a snapshot of the tree rooted at the specified context, which is included in the snapshot
+  /// </summary>
+  ContextSnapshot(const std::shared_ptr<CoreContext>& root);
+
+private:
+  struct Entry {
+    std::weak_ptr<CoreContext> context;
+
+    // One past the index of the last entry in the subtree rooted at this entry
+    size_t end;
+  };
+
+  // Contexts in preorder
+  std::vector<Entry> m_entries;
+
+  void Append(const std::shared_ptr<CoreContext>& ctxt);
+
+public:
+  /// <returns>The number of contexts recorded in the snapshot, some of which may have since been destroyed</returns>
+  size_t size(void) const { return m_entries.size(); }
+
+  /// <summary>
+  /// Invokes fn on each recorded context that still exists, in preorder
+  /// </summary>
+  void Visit(const std::function<void(const std::shared_ptr<CoreContext>&)>& fn) const;
+
+  /// <summary>
+  /// Invokes fn on each recorded context that still exists, from up to nWorkers threads at once
+  /// </summary>
+  /// <param name="nWorkers">The number of threads, including the calling thread, or zero for one per hardware thread</param>
+  /// <remarks>
+  /// The tree is divided into subtrees, which are handed out to the workers as they become free.  Each
+  /// subtree is visited in preorder by a single worker, but no order is defined between subtrees, and so
+  /// fn must be thread safe.  A context may be visited after some of its descendants.  The first exception
+  /// thrown by fn is rethrown once every subtree has been visited.
+  /// </remarks>
+  void Visit(const std::function<void(const std::shared_ptr<CoreContext>&)>& fn, size_t nWorkers) const;
+};
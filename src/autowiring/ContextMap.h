@@ -109,7 +109,7 @@ public:
     bool operator==(const iterator& rhs) const { return &parent == &rhs.parent && iter == rhs.iter; }
     bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
     explicit operator bool(void) const {
-      return ctxt;
+      return !!ctxt;
     }
   };
 
@@ -0,0 +1,82 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "auto_id.h"
+
+class CoreContext;
+
+namespace autowiring {
+
+/// <summary>
+/// The phases of context construction and startup that are reported to a ContextProfiler
+/// </summary>
+enum class StartupPhase {
+  // Construction of an injected type, including anything injected by its constructor
+  Construct,
+
+  // The AutoInit call made on an injected type
+  AutoInit,
+
+  // Satisfaction of deferred Autowired slots after a member is added to a context
+  ResolveSlots,
+
+  // Notification of bolts that a context with a particular sigil was created
+  NotifyBolts,
+
+  // The call to CoreRunnable::Start made on a member when its context starts running
+  StartRunnable
+};
+
+/// <summary>
+/// Receives notice of the beginning and end of each phase of context construction and startup
+/// </summary>
+/// <remarks>
+/// A profiler is attached to a context with CoreContext::SetProfiler, and is inherited by contexts
+/// subsequently created as children of that context.  Phases nest on a single thread: a type whose
+/// constructor injects another type will report the construction of the second type between the
+/// Enter and Leave calls made for the first.  Phases on different threads may be reported at the
+/// same time, implementations must be thread safe.  Enter and Leave are never called while the
+/// context's lock is held, so a profiler may query the context from either.
+/// </remarks>
+class ContextProfiler {
+public:
+  virtual ~ContextProfiler(void) {}
+
+  /// <summary>
+  /// Called when a phase begins on the calling thread
+  /// </summary>
+  /// <param name="ctxt">The context where the phase is taking place</param>
+  /// <param name="phase">The phase that is beginning</param>
+  /// <param name="type">The member type, or for NotifyBolts the sigil type, to which the phase pertains</param>
+  virtual void Enter(const CoreContext& ctxt, StartupPhase phase, auto_id type) = 0;
+
+  /// <summary>
+  /// Called when the phase most recently entered on the calling thread has ended
+  /// </summary>
+  virtual void Leave(void) = 0;
+};
+
+/// \internal
+/// <summary>
+/// Reports a phase to a profiler for the lifetime of this object, does nothing if there is no profiler
+/// </summary>
+class ProfileScope {
+public:
+  ProfileScope(ContextProfiler* pProfiler, const CoreContext& ctxt, StartupPhase phase, auto_id type) :
+    m_pProfiler(pProfiler)
+  {
+    if (m_pProfiler)
+      m_pProfiler->Enter(ctxt, phase, type);
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+
+  ~ProfileScope(void) {
+    if (m_pProfiler)
+      m_pProfiler->Leave();
+  }
+
+private:
+  ContextProfiler* const m_pProfiler;
+};
+
+}
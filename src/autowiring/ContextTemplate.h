@@ -0,0 +1,177 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "CoreContext.h"
+#include FUNCTIONAL_HEADER
+#include MEMORY_HEADER
+#include MUTEX_HEADER
+#include <vector>
+
+/// <summary>
+/// A pre-warm queue of child contexts of a fixed shape
+/// </summary>
+/// <param name="Sigil">The sigil of the contexts to be created</param>
+/// <remarks>
+/// A template records the members of a context once, and Create issues a context that already holds
+/// all of them.  Nothing is resolved ahead of time: each context is still created with Create<Sigil>,
+/// and each member is injected and has its Autowired fields resolved, exactly as if the caller had
+/// done so.  The total cost of a context is therefore unchanged.  What the template offers is Reserve,
+/// which pays that cost ahead of time on whichever thread calls it, so that Create only has to take a
+/// context from the reserve.  This helps when requests arrive in bursts, or when a thread can be
+/// spared to keep the reserve full; it does not raise sustained throughput.
+///
+/// Contexts cannot be restarted once they have been initiated or shut down, and so issued contexts
+/// are never returned to the template.  Each context is issued exactly once.
+///
+/// Reserved contexts are children of the parent context and are visible to its enumerators.  When
+/// the parent is shut down, the reserve is discarded and no further contexts are reserved.  All
+/// methods are thread safe.
+/// </remarks>
+template<class Sigil>
+class ContextTemplate {
+public:
+  /// <param name="parent">The context under which contexts will be created</param>
+  ContextTemplate(std::shared_ptr<CoreContext> parent = CoreContext::CurrentContext()) :
+    m_state(std::make_shared<State>(std::move(parent)))
+  {
+    std::weak_ptr<State> weakState = m_state;
+    m_state->onShutdownReg = m_state->parent->onShutdown += [weakState] {
+      auto state = weakState.lock();
+      if (!state)
+        return;
+
+      std::vector<std::shared_ptr<CoreContext>> discarded;
+      std::lock_guard<std::mutex> lk(state->lock);
+      state->stopped = true;
+      discarded.swap(state->reserve);
+    };
+  }
+
+private:
+  struct State {
+    State(std::shared_ptr<CoreContext> parent) :
+      parent(std::move(parent))
+    {}
+
+    ~State(void) {
+      parent->onShutdown -= onShutdownReg;
+    }
+
+    std::mutex lock;
+    const std::shared_ptr<CoreContext> parent;
+    autowiring::registration_t onShutdownReg;
+
+    // Injectors for each member, in order of registration
+    std::vector<std::function<void(CoreContext&)>> members;
+
+    // Incremented whenever a member is added, so that contexts stamped from an older member list
+    // are not reserved
+    size_t generation = 0;
+
+    // Set once the parent has been shut down, after which nothing is reserved
+    bool stopped = false;
+
+    // Stamped contexts ready to be issued
+    std::vector<std::shared_ptr<CoreContext>> reserve;
+  };
+
+  std::shared_ptr<State> m_state;
+
+  static std::shared_ptr<CoreContext> Stamp(State& state, size_t* pGeneration = nullptr) {
+    std::vector<std::function<void(CoreContext&)>> members;
+    {
+      std::lock_guard<std::mutex> lk(state.lock);
+      members = state.members;
+      if (pGeneration)
+        *pGeneration = state.generation;
+    }
+
+    std::shared_ptr<CoreContext> ctxt = state.parent->template Create<Sigil>();
+    for (auto& member : members)
+      member(*ctxt);
+    return ctxt;
+  }
+
+public:
+  /// <summary>
+  /// Adds a member of type T to every context created by this template
+  /// </summary>
+  /// <remarks>
+  /// Reserved contexts which do not yet hold the new member are discarded.
+  /// </remarks>
+  template<class T>
+  ContextTemplate& Add(void) {
+    std::vector<std::shared_ptr<CoreContext>> discarded;
+    std::lock_guard<std::mutex> lk(m_state->lock);
+    m_state->members.push_back([](CoreContext& ctxt) { ctxt.Inject<T>(); });
+    m_state->generation++;
+    discarded.swap(m_state->reserve);
+    return *this;
+  }
+
+  /// <returns>The number of contexts ready to be issued without being stamped</returns>
+  size_t GetReservedCount(void) const {
+    std::lock_guard<std::mutex> lk(m_state->lock);
+    return m_state->reserve.size();
+  }
+
+  /// <summary>
+  /// Stamps contexts ahead of time until at least the specified number are ready to be issued
+  /// </summary>
+  /// <remarks>
+  /// Each context is stamped on the calling thread at the full cost of creating it.  Has no effect once
+  /// the parent context has been shut down.
+  /// </remarks>
+  void Reserve(size_t n) {
+    for (;;) {
+      {
+        std::lock_guard<std::mutex> lk(m_state->lock);
+        if (m_state->stopped || m_state->reserve.size() >= n)
+          return;
+      }
+
+      size_t generation;
+      std::shared_ptr<CoreContext> ctxt = Stamp(*m_state, &generation);
+      std::lock_guard<std::mutex> lk(m_state->lock);
+      if (m_state->stopped)
+        return;
+
+      // A member added while this context was being stamped is missing from it, so it is discarded
+      if (generation != m_state->generation)
+        continue;
+      m_state->reserve.push_back(std::move(ctxt));
+    }
+  }
+
+  /// <summary>
+  /// Discards all reserved contexts
+  /// </summary>
+  void Clear(void) {
+    std::vector<std::shared_ptr<CoreContext>> discarded;
+    std::lock_guard<std::mutex> lk(m_state->lock);
+    discarded.swap(m_state->reserve);
+  }
+
+  /// <summary>
+  /// Issues a context holding every member of this template
+  /// </summary>
+  /// <remarks>
+  /// The context is taken from the reserve if one is available, and is otherwise stamped on the
+  /// calling thread.  Reserved contexts which have since been shut down are discarded rather than
+  /// issued.  The returned pointer is the context's own, so it shares a control block with
+  /// shared_from_this.
+  /// </remarks>
+  std::shared_ptr<CoreContext> Create(void) {
+    std::vector<std::shared_ptr<CoreContext>> discarded;
+    {
+      std::lock_guard<std::mutex> lk(m_state->lock);
+      while (!m_state->reserve.empty()) {
+        std::shared_ptr<CoreContext> ctxt = std::move(m_state->reserve.back());
+        m_state->reserve.pop_back();
+        if (!ctxt->IsShutdown())
+          return ctxt;
+        discarded.push_back(std::move(ctxt));
+      }
+    }
+    return Stamp(*m_state);
+  }
+};
@@ -5,15 +5,19 @@
 #include "AutowirableSlot.h"
 #include "CoreThread.h"
 #include "demangle.h"
+#include "ForEachConcurrently.h"
 #include "GlobalCoreContext.h"
 #include "ManualThreadPool.h"
 #include "MicroBolt.h"
 #include "NullPool.h"
 #include "SystemThreadPool.h"
 #include "thread_specific_ptr.h"
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <sstream>
 #include <stdexcept>
+#include FUNCTIONAL_HEADER
 
 using namespace autowiring;
 
@@ -40,6 +44,17 @@ public:
   }
 };
 
+#ifdef AUTOWIRING_USE_THREAD_LOCAL
+/// <summary>
+/// The slot owned by autoCurrentContext on this thread, read without a call to the thread-specific storage API
+/// </summary>
+/// <remarks>
+/// autoCurrentContext remains responsible for destroying the slot when the thread exits, and clears this pointer
+/// when it does so.
+/// </remarks>
+static thread_local std::shared_ptr<CoreContext>* tlsCurrentContext = nullptr;
+#endif
+
 /// <summary>
 /// A pointer to the current context, specific to the current thread.
 /// </summary>
@@ -49,7 +64,36 @@ public:
 /// to the global context directly because it could change teardown order if the main thread sets the global context
 /// as current.
 /// </remarks>
-static thread_specific_ptr<std::shared_ptr<CoreContext>> autoCurrentContext;
+static thread_specific_ptr<std::shared_ptr<CoreContext>> autoCurrentContext(
+  [] (void* ptr) {
+#ifdef AUTOWIRING_USE_THREAD_LOCAL
+    tlsCurrentContext = nullptr;
+#endif
+    delete static_cast<std::shared_ptr<CoreContext>*>(ptr);
+  }
+);
+
+/// <returns>The current context slot of this thread, or null if the thread has not yet been given one</returns>
+static std::shared_ptr<CoreContext>* CurrentContextSlot(void) {
+#ifdef AUTOWIRING_USE_THREAD_LOCAL
+  return tlsCurrentContext;
+#else
+  return autoCurrentContext.get();
+#endif
+}
+
+/// <returns>The current context slot of this thread, which is created if necessary</returns>
+static std::shared_ptr<CoreContext>& CurrentContextSlotOrCreate(void) {
+  if (auto* slot = CurrentContextSlot())
+    return *slot;
+
+  auto* slot = new std::shared_ptr<CoreContext>;
+  autoCurrentContext.reset(slot);
+#ifdef AUTOWIRING_USE_THREAD_LOCAL
+  tlsCurrentContext = slot;
+#endif
+  return *slot;
+}
 
 // Peer Context Constructor. Called interally by CreatePeer
 CoreContext::CoreContext(const std::shared_ptr<CoreContext>& pParent, t_childList::iterator backReference, auto_id sigilType) :
@@ -57,7 +101,8 @@ CoreContext::CoreContext(const std::shared_ptr<CoreContext>& pParent, t_childLis
   m_backReference(backReference),
   SigilType(sigilType),
   AncestorCount(pParent ? pParent->AncestorCount + 1 : 0),
-  m_stateBlock(std::make_shared<CoreContextStateBlock>(pParent ? pParent->m_stateBlock : nullptr))
+  m_stateBlock(std::make_shared<CoreContextStateBlock>(pParent ? pParent->m_stateBlock : nullptr)),
+  m_profiler(pParent ? pParent->m_profiler : nullptr)
 {}
 
 CoreContext::~CoreContext(void) {
@@ -67,16 +112,22 @@ CoreContext::~CoreContext(void) {
     expiredContext();
 
     // Also clear out any parent pointers:
-    std::lock_guard<std::mutex> lk(m_pParent->m_stateBlock->m_lock);
-    m_pParent->m_children.erase(m_backReference);
+    {
+      std::lock_guard<std::mutex> lk(m_pParent->m_stateBlock->m_lock);
+      m_pParent->m_children.erase(m_backReference);
+      m_pParent->m_childrenVersion++;
+    }
+
+    // The parent's copy of its child list is out of date, and would otherwise hold our storage
+    std::atomic_store(&m_pParent->m_childSnapshot, std::shared_ptr<const ChildSnapshot>());
   }
 
   // The autoCurrentContext pointer holds a shared_ptr to this--if we're in a dtor, and our caller
   // still holds a reference to us, then we have a serious problem.
   assert(
-    !autoCurrentContext.get() ||
-    !autoCurrentContext.get()->use_count() ||
-    autoCurrentContext.get()->get() != this
+    !CurrentContextSlot() ||
+    !CurrentContextSlot()->use_count() ||
+    CurrentContextSlot()->get() != this
   );
 
   // Notify all ContextMember instances that their parent is going away
@@ -153,7 +204,10 @@ std::shared_ptr<CoreContext> CoreContext::CreateInternal(t_pfnCreate pfnCreate)
     retVal->m_state = State::CanRun;
 
   // Fire all explicit bolts if not an "anonymous" context (has void sigil type)
-  BroadcastContextCreationNotice(retVal->GetSigilType());
+  {
+    ProfileScope scope(m_profiler.get(), *retVal, StartupPhase::NotifyBolts, retVal->GetSigilType());
+    BroadcastContextCreationNotice(retVal->GetSigilType());
+  }
 
   // We only consider the context to be completely constructed at this point, after all bolts
   // have been fired, the injection has taken place, and we're about to return.  We delay
@@ -161,6 +215,7 @@ std::shared_ptr<CoreContext> CoreContext::CreateInternal(t_pfnCreate pfnCreate)
   // reason.
   std::lock_guard<std::mutex> lk(m_stateBlock->m_lock);
   *childIterator = retVal;
+  m_childrenVersion++;
   if(IsShutdown())
     retVal->SignalShutdown();
   return retVal;
@@ -211,6 +266,30 @@ std::shared_ptr<CoreContext> CoreContext::NextSibling(void) const {
   return nullptr;
 }
 
+std::shared_ptr<const CoreContext::ChildSnapshot> CoreContext::GetChildSnapshot(void) const {
+  // Contexts which have never had a child share one empty copy
+  static const std::shared_ptr<const ChildSnapshot> empty = std::make_shared<ChildSnapshot>();
+  if (!m_childrenVersion)
+    return empty;
+
+  auto snapshot = std::atomic_load(&m_childSnapshot);
+  if (snapshot && snapshot->version == m_childrenVersion)
+    return snapshot;
+
+  // Out of date, make a new copy.  The version is read under the same lock as the list.
+  auto fresh = std::make_shared<ChildSnapshot>();
+  {
+    std::lock_guard<std::mutex> lk(m_stateBlock->m_lock);
+    fresh->version = m_childrenVersion;
+    fresh->children.reserve(m_children.size());
+    for (const auto& child : m_children)
+      if (!child.expired())
+        fresh->children.push_back(child);
+  }
+  std::atomic_store(&m_childSnapshot, std::shared_ptr<const ChildSnapshot>(fresh));
+  return fresh;
+}
+
 auto_id CoreContext::GetAutoTypeId(const AnySharedPointer& ptr) const {
   std::lock_guard<std::mutex> lk(m_stateBlock->m_lock);
 
@@ -251,14 +330,21 @@ void CoreContext::AddInternal(const CoreObjectDescriptor& traits) {
     // These are all trivial containers that we take the opportunity to update here while we are
     // under lock.  Changes to these containers do not cause any signals to be asserted so we are
     // safe to do this.
+    IndexMembersUnsafe();
     m_concreteTypes.push_back(traits);
+    const CoreObjectDescriptor& desc = m_concreteTypes.back();
+    std::vector<auto_id> implemented;
+    if (desc.pRelations)
+      desc.pRelations->Implemented(desc.pCoreObject, 0, m_nClassified, implemented);
+    m_implementors.emplace(desc.type, &desc);
+    IndexMemberUnsafe(desc, implemented);
     if(traits.pContextMember)
       m_contextMembers.push_back(traits.pContextMember.get());
     if(traits.pFilter)
       m_filters.push_back(traits.pFilter.get());
 
     // Notify any autowiring field that is currently waiting that we have a new member to be considered.
-    UpdateDeferredElements(std::move(lk), m_concreteTypes.back(), true);
+    UpdateDeferredElements(std::move(lk), desc, implemented, true);
   }
 
   // Tell anyone interested that we are done adding the type
@@ -299,31 +385,65 @@ void CoreContext::AddInternal(const AnySharedPointer& ptr) {
 }
 
 MemoEntry& CoreContext::FindByType(auto_id type, bool nonrecursive) const {
+  // Memo entries are never removed, so an entry found here is the same one the locked search would find
+  if (MemoEntry* pEntry = m_memoIndex.Find(type))
+    return *pEntry;
+
   std::lock_guard<std::mutex> lk(m_stateBlock->m_lock);
   return FindByTypeUnsafe(type, nonrecursive);
 }
 
+void CoreContext::IndexMemberUnsafe(const CoreObjectDescriptor& desc, const std::vector<auto_id>& implemented) const {
+  // Members are always indexed under their own type when they are added
+  for (auto_id type : implemented)
+    if (type != desc.type)
+      m_implementors.emplace(type, &desc);
+}
+
+void CoreContext::IndexMembersUnsafe(void) const {
+  size_t nRegistered = autowiring::TypeRelations::GetRegisteredCount();
+  if (m_nClassified >= nRegistered)
+    return;
+
+  std::vector<auto_id> implemented;
+  for (const auto& concreteType : m_concreteTypes)
+    if (concreteType.pRelations) {
+      implemented.clear();
+      concreteType.pRelations->Implemented(concreteType.pCoreObject, m_nClassified, nRegistered, implemented);
+      IndexMemberUnsafe(concreteType, implemented);
+    }
+  m_nClassified = nRegistered;
+}
+
 MemoEntry& CoreContext::FindByTypeUnsafe(auto_id type, bool nonrecursive) const {
   // If we've attempted to search for this type before, we will return the value of the memo immediately:
   auto q = m_typeMemos.find(type);
-  if(q != m_typeMemos.end())
-    // Done, can return here
+  if(q != m_typeMemos.end()) {
+    // Done, can return here.  The entry may have been left unpublished if its resolution failed.
+    m_memoIndex.Publish(type, q->second);
     return q->second;
+  }
 
   // Ensure the memo at least receives a default value:
   MemoEntry& retVal = m_typeMemos[type];
   retVal.m_value = type;
 
-  // Resolve based on iterated dynamic casts for each concrete type:
-  for(const auto& concreteType : m_concreteTypes) {
+  // Once the type is registered, the index lists every member that implements it.  Otherwise only
+  // members of exactly this type can be found, and later members are tested against it one by one.
+  if (autowiring::TypeRelations::Register(type))
+    IndexMembersUnsafe();
+  else
+    m_uncastMemos.push_back(&retVal);
+
+  auto implementors = m_implementors.equal_range(type);
+  for(auto q = implementors.first; q != implementors.second; ++q) {
+    const auto& concreteType = *q->second;
     if (type == concreteType.type)
       // Exact match, no dynamic casting required:
       retVal.m_value = concreteType.value;
-    else if(type.block->pFromObj) {
-      // Dynamic match next
-      auto fromObj = type.block->pFromObj(concreteType.pCoreObject);
+    else {
+      auto fromObj = concreteType.pRelations->Cast(concreteType.pCoreObject, type);
       if (!fromObj)
-        // No match, try the next entry
         continue;
 
       // Match!  Assign, and signal this entry preemptively
@@ -331,9 +451,6 @@ MemoEntry& CoreContext::FindByTypeUnsafe(auto_id type, bool nonrecursive) const
       retVal.m_value = fromObj;
       retVal.m_local = true;
     }
-    else
-      // No caster available, we need to recycle
-      continue;
 
     if (retVal.pObjTraits)
       // Resolution ambiguity, cannot proceed
@@ -343,8 +460,10 @@ MemoEntry& CoreContext::FindByTypeUnsafe(auto_id type, bool nonrecursive) const
     retVal.pObjTraits = &concreteType;
   }
 
-  if (nonrecursive || !m_pParent || retVal.m_value)
+  if (nonrecursive || !m_pParent || retVal.m_value) {
+    m_memoIndex.Publish(type, retVal);
     return retVal;
+  }
 
   // Recurse to parent while holding lock
   auto& parentEntry = m_pParent->FindByType(type, nonrecursive);
@@ -354,10 +473,12 @@ MemoEntry& CoreContext::FindByTypeUnsafe(auto_id type, bool nonrecursive) const
     retVal.pObjTraits = parentEntry.pObjTraits;
     retVal.m_local = false;
     retVal.onSatisfied = true;
+    m_memoIndex.Publish(type, retVal);
     return parentEntry;
   }
 
   // Failure, return our own entry, the signal defined here will be satisfied
+  m_memoIndex.Publish(type, retVal);
   return retVal;
 }
 
@@ -432,11 +553,7 @@ void CoreContext::Initiate(void) {
   onInitiated();
   m_stateBlock->m_stateChanged.notify_all();
 
-  if (beginning != m_threads.end()) {
-    auto outstanding = m_stateBlock->IncrementOutstandingThreadCount(shared_from_this());
-    for (auto q = beginning; q != m_threads.end(); ++q)
-      (*q)->Start(outstanding);
-  }
+  StartRunnables(beginning);
 
   // We assert this condition only after all threads have been at least notified that they can start
   onRunning();
@@ -445,6 +562,82 @@ void CoreContext::Initiate(void) {
   TryTransitionChildrenState();
 }
 
+void CoreContext::StartRunnables(std::list<CoreRunnable*>::iterator first) {
+  if (first == m_threads.end())
+    return;
+
+  // Pair each runnable with the descriptor of the member that provides it
+  std::vector<std::pair<CoreRunnable*, const CoreObjectDescriptor*>> runnables;
+  {
+    std::lock_guard<std::mutex> lk(m_stateBlock->m_lock);
+    std::unordered_map<CoreRunnable*, const CoreObjectDescriptor*> descs;
+    for (const auto& concreteType : m_concreteTypes)
+      if (concreteType.pCoreRunnable)
+        descs[concreteType.pCoreRunnable.get()] = &concreteType;
+
+    for (auto q = first; q != m_threads.end(); ++q) {
+      auto desc = descs.find(*q);
+      runnables.push_back({*q, desc == descs.end() ? nullptr : desc->second});
+    }
+  }
+
+  auto outstanding = m_stateBlock->IncrementOutstandingThreadCount(shared_from_this());
+  if (m_startupConcurrency > 1 && runnables.size() > 1)
+    StartRunnablesParallel(runnables, outstanding);
+  else
+    for (const auto& runnable : runnables)
+      StartRunnable(*runnable.first, runnable.second, outstanding);
+}
+
+void CoreContext::StartRunnablesParallel(
+  const std::vector<std::pair<CoreRunnable*, const CoreObjectDescriptor*>>& runnables,
+  const std::shared_ptr<CoreObject>& outstanding
+) {
+  // Dependency graph among the runnables being started.  Runnable i depends on runnable j if a slot
+  // on i is satisfied by j.
+  const size_t n = runnables.size();
+  std::vector<std::vector<size_t>> dependents(n);
+  {
+    std::unordered_map<const CoreObjectDescriptor*, size_t> indexes;
+    for (size_t i = 0; i < n; i++)
+      if (runnables[i].second)
+        indexes[runnables[i].second] = i;
+
+    std::lock_guard<std::mutex> lk(m_stateBlock->m_lock);
+    for (size_t i = 0; i < n; i++) {
+      if (!runnables[i].second)
+        continue;
+
+      for (auto cur = runnables[i].second->stump->pHead; cur; cur = cur->pFlink) {
+        auto memo = m_typeMemos.find(cur->type);
+        if (memo == m_typeMemos.end() || !memo->second.m_local)
+          continue;
+
+        auto dependency = indexes.find(memo->second.pObjTraits);
+        if (dependency == indexes.end() || dependency->second == i)
+          continue;
+
+        dependents[dependency->second].push_back(i);
+      }
+    }
+  }
+
+  ForEachConcurrently(
+    n,
+    m_startupConcurrency,
+    std::move(dependents),
+    [&](size_t i) { StartRunnable(*runnables[i].first, runnables[i].second, outstanding); }
+  );
+}
+
+void CoreContext::StartRunnable(CoreRunnable& runnable, const CoreObjectDescriptor* pDesc, const std::shared_ptr<CoreObject>& outstanding) {
+  ProfileScope scope(m_profiler.get(), *this, StartupPhase::StartRunnable, pDesc ? pDesc->type : auto_id{});
+  auto start = std::chrono::steady_clock::now();
+  runnable.Start(outstanding);
+  if (pDesc)
+    runnableStarted(*pDesc, std::chrono::steady_clock::now() - start);
+}
+
 void CoreContext::SignalShutdown(bool wait, ShutdownMode shutdownMode) {
   // As we signal shutdown, there may be a CoreRunnable that is in the "running" state.  If so,
   // then we will skip that thread as we signal the list of threads to shutdown.
@@ -519,8 +712,16 @@ void CoreContext::SignalShutdown(bool wait, ShutdownMode shutdownMode) {
   }
 
   // Now that we have a locked-down, immutable series, begin termination signalling:
-  for(size_t i = childrenInterleave.size(); i--; )
-    childrenInterleave[i]->SignalShutdown(false, shutdownMode);
+  const bool concurrent = m_teardownConcurrency > 1 && childrenInterleave.size() > 1;
+  if (concurrent)
+    ForEachConcurrently(
+      childrenInterleave.size(),
+      m_teardownConcurrency,
+      [&](size_t i) { childrenInterleave[i]->SignalShutdown(false, shutdownMode); }
+    );
+  else
+    for(size_t i = childrenInterleave.size(); i--; )
+      childrenInterleave[i]->SignalShutdown(false, shutdownMode);
 
   // Pass notice to all child threads:
   bool graceful = (shutdownMode == ShutdownMode::Graceful);
@@ -530,6 +731,15 @@ void CoreContext::SignalShutdown(bool wait, ShutdownMode shutdownMode) {
   // Wait if requested
   if(wait)
     Wait();
+
+  // Children are otherwise released in order when the interleave goes out of scope.  Releasing them
+  // here allows those which are not referenced elsewhere to be destroyed concurrently.
+  if (concurrent)
+    ForEachConcurrently(
+      childrenInterleave.size(),
+      m_teardownConcurrency,
+      [&](size_t i) { childrenInterleave[i].reset(); }
+    );
 }
 
 void CoreContext::Quiescent(void) const {
@@ -565,12 +775,12 @@ bool CoreContext::DelayUntilInitiated(void) {
 
 const std::shared_ptr<CoreContext>& CoreContext::CurrentContextOrNull(void) {
   static const std::shared_ptr<CoreContext> empty;
-  auto retVal = autoCurrentContext.get();
+  auto retVal = CurrentContextSlot();
   return retVal ? *retVal : empty;
 }
 
 std::shared_ptr<CoreContext> CoreContext::CurrentContext(void) {
-  if (auto* retVal = autoCurrentContext.get())
+  if (auto* retVal = CurrentContextSlot())
     if(*retVal)
       return *retVal;
   return GetGlobalContext();
@@ -615,23 +825,29 @@ void CoreContext::AddCoreRunnable(const std::shared_ptr<CoreRunnable>& ptr) {
 }
 
 void CoreContext::AddBolt(const std::shared_ptr<BoltBase>& pBase) {
+  // Sigils of interest to this bolt, an empty list matches every context
+  std::vector<auto_id> sigils;
+  for (auto cur = pBase->GetContextSigils(); *cur; cur++)
+    sigils.push_back(*cur);
+
   // Register all listeners as needed under lock
   {
     std::lock_guard<std::mutex> lk{ m_stateBlock->m_lock };
-    for (auto cur = pBase->GetContextSigils(); *cur; cur++)
-      m_nameListeners[*cur].push_back(pBase.get());
-    if(!*pBase->GetContextSigils())
+    for (auto sigil : sigils)
+      m_nameListeners[sigil].push_back(pBase.get());
+    if(sigils.empty())
       m_nameListeners[{}].push_back(pBase.get());
+    m_nBolts++;
   }
 
   // We intend to reset the context just once, when the function is done
   CurrentContextPusher pshr;
 
-  // Post-hoc invocation of all already-created contexts:
+  // Post-hoc invocation of all already-created contexts, made in a single traversal
   ContextEnumerator e{ shared_from_this() };
   for (auto q = e.begin(); ++q != e.end(); ) {
-    if (!pBase->Matches(q->GetSigilType()))
-      break;
+    if (!sigils.empty() && std::find(sigils.begin(), sigils.end(), q->GetSigilType()) == sigils.end())
+      continue;
 
     q->SetCurrent();
     pBase->ContextCreated();
@@ -710,20 +926,26 @@ void ShutdownCurrentContext(void) {
 }
 
 void CoreContext::BroadcastContextCreationNotice(auto_id sigil) const {
-  auto listeners = m_nameListeners.find(sigil);
-  if(listeners != m_nameListeners.end()) {
-    // Iterate through all listeners:
-    for(BoltBase* bolt : listeners->second)
-      bolt->ContextCreated();
-  }
+  if (m_nBolts) {
+    // Recipients are collected under lock and notified without it, they may create contexts of their own
+    std::vector<BoltBase*> bolts;
+    {
+      std::lock_guard<std::mutex> lk{ m_stateBlock->m_lock };
+      auto listeners = m_nameListeners.find(sigil);
+      if (listeners != m_nameListeners.end())
+        bolts = listeners->second;
+
+      // In the case of an anonymous sigil type, we do not notify the all-types
+      // listeners a second time.
+      if (sigil != auto_id{}) {
+        listeners = m_nameListeners.find({});
+        if (listeners != m_nameListeners.end())
+          bolts.insert(bolts.end(), listeners->second.begin(), listeners->second.end());
+      }
+    }
 
-  // In the case of an anonymous sigil type, we do not notify the all-types
-  // listeners a second time.
-  if (sigil != auto_id{}) {
-    listeners = m_nameListeners.find({});
-    if(listeners != m_nameListeners.end())
-      for(BoltBase* bolt : listeners->second)
-        bolt->ContextCreated();
+    for (BoltBase* bolt : bolts)
+      bolt->ContextCreated();
   }
 
   // Notify the parent next:
@@ -755,40 +977,52 @@ void CoreContext::UpdateDeferredElement(std::unique_lock<std::mutex>&& lk, MemoE
   lk.unlock();
 }
 
-void CoreContext::UpdateDeferredElements(std::unique_lock<std::mutex>&& lk, const CoreObjectDescriptor& entry, bool local) {
-  {
-    std::vector<MemoEntry*> entries;
+void CoreContext::UpdateDeferredElements(std::unique_lock<std::mutex>&& lk, const CoreObjectDescriptor& entry, const std::vector<auto_id>& implemented, bool local) {
+  std::vector<MemoEntry*> entries;
 
-    // Notify any autowired field whose autowiring was deferred.  We do this by processing each entry
-    // in the entire type memos collection.
-    for (auto& cur : m_typeMemos) {
-      MemoEntry& value = cur.second;
+  // Notify any autowired field whose autowiring was deferred.  Only the entries for interfaces this
+  // member implements are considered, along with any entries that could not be registered.
+  auto satisfy = [&] (MemoEntry& value) {
+    if (value.m_value && value.m_local)
+      // This entry is already satisfied locally, no need to process it
+      return;
 
-      if (value.m_value && value.m_local)
-        // This entry is already satisfied locally, no need to process it
-        continue;
+    // Determine whether the current candidate element satisfies the autowiring we are considering.
+    // This is done internally via a dynamic cast on the interface type for which this polymorphic
+    // base type was constructed.
+    auto ptr = entry.pRelations->Cast(entry.pCoreObject, value.m_value.type());
+    if (!ptr)
+      return;
 
-      // Determine whether the current candidate element satisfies the autowiring we are considering.
-      // This is done internally via a dynamic cast on the interface type for which this polymorphic
-      // base type was constructed.
-      if (!value.m_value.try_assign(entry.pCoreObject))
-        continue;
+    *value.m_value = std::move(ptr);
+    entries.push_back(&value);
 
-      entries.push_back(&value);
+    // Success, assign the traits
+    value.pObjTraits = &entry;
 
-      // Success, assign the traits
-      value.pObjTraits = &entry;
+    // Store if it was injected from the local context or not
+    value.m_local = local;
+  };
 
-      // Store if it was injected from the local context or not
-      value.m_local = local;
-    }
+  for (auto_id type : implemented) {
+    auto q = m_typeMemos.find(type);
+    if (q != m_typeMemos.end())
+      satisfy(q->second);
+  }
 
-    lk.unlock();
+  if (entry.pRelations)
+    for (MemoEntry* pValue : m_uncastMemos)
+      satisfy(*pValue);
 
-    // Fire off notifications that satisfaction has taken place
-    for (auto e: entries)
-      e->onSatisfied();
-  }
+  lk.unlock();
+
+  // The profiler is only called without the lock held, so that it may call back into this context.
+  // Resolution in child contexts is attributed to the context where the member was added.
+  ProfileScope scope(local ? m_profiler.get() : nullptr, *this, StartupPhase::ResolveSlots, entry.type);
+
+  // Fire off notifications that satisfaction has taken place
+  for (auto e: entries)
+    e->onSatisfied();
 
   // Give children a chance to also update their deferred elements:
   lk.lock();
@@ -803,10 +1037,12 @@ void CoreContext::UpdateDeferredElements(std::unique_lock<std::mutex>&& lk, cons
     ctxt->UpdateDeferredElements(
       std::unique_lock<std::mutex>(ctxt->m_stateBlock->m_lock),
       entry,
+      implemented,
       false
     );
     lk.lock();
   }
+  lk.unlock();
 }
 
 void CoreContext::FilterException(void) {
@@ -917,11 +1153,7 @@ void CoreContext::TryTransitionChildrenState(void) {
             // Child had it's state changed
             child->m_stateBlock->m_stateChanged.notify_all();
 
-            auto outstanding = child->m_stateBlock->IncrementOutstandingThreadCount(child);
-            while (q != child->m_threads.end()) {
-              (*q)->Start(outstanding);
-              q++;
-            }
+            child->StartRunnables(q);
             child->onRunning();
           }
 
@@ -985,9 +1217,10 @@ std::shared_ptr<CoreContext> CoreContext::SetCurrent(const std::shared_ptr<CoreC
   if (currentContext == ctxt)
     return currentContext;
 
-  // Value is changing, update:
-  auto retVal = currentContext;
-  autoCurrentContext = ctxt;
+  // Value is changing, exchange it for the prior value:
+  auto& slot = CurrentContextSlotOrCreate();
+  auto retVal = std::move(slot);
+  slot = ctxt;
   return retVal;
 }
 
@@ -998,9 +1231,10 @@ std::shared_ptr<CoreContext> CoreContext::SetCurrent(std::shared_ptr<CoreContext
   if (currentContext == ctxt)
     return currentContext;
 
-  // Value is changing, update:
-  auto retVal = currentContext;
-  autoCurrentContext = std::move(ctxt);
+  // Value is changing, exchange it for the prior value:
+  auto& slot = CurrentContextSlotOrCreate();
+  auto retVal = std::move(slot);
+  slot = std::move(ctxt);
   return retVal;
 }
 
@@ -1009,5 +1243,6 @@ std::shared_ptr<CoreContext> CoreContext::SetCurrent(void) {
 }
 
 void CoreContext::EvictCurrent(void) {
-  *autoCurrentContext = nullptr;
+  if (auto* slot = CurrentContextSlot())
+    *slot = nullptr;
 }
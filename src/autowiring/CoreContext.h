@@ -10,6 +10,7 @@
 #include "ConfigManager.h"
 #include "ConfigBolt.h"
 #include "ContextMember.h"
+#include "ContextProfiler.h"
 #include "CoreContextStateBlock.h"
 #include "CoreObjectDescriptor.h"
 #include "CreationRules.h"
@@ -23,8 +24,12 @@
 #include "TypeRegistry.h"
 #include "TypeUnifier.h"
 
+#include <algorithm>
+#include <atomic>
 #include <list>
+#include CHRONO_HEADER
 #include MEMORY_HEADER
+#include THREAD_HEADER
 #include TYPE_INDEX_HEADER
 #include STL_UNORDERED_MAP
 
@@ -108,6 +113,16 @@ class CoreContext:
 {
 protected:
   typedef std::list<std::weak_ptr<CoreContext>> t_childList;
+
+  /// <summary>
+  /// An immutable copy of the child list of a context, see GetChildSnapshot
+  /// </summary>
+  struct ChildSnapshot {
+    // The version of the child list that was copied
+    size_t version;
+
+    std::vector<std::weak_ptr<CoreContext>> children;
+  };
   CoreContext(const CoreContext&) = delete;
   CoreContext(const std::shared_ptr<CoreContext>& pParent, t_childList::iterator backReference, auto_id sigilType);
 
@@ -136,6 +151,10 @@ public:
   // Asserted any time a new object is added to the context
   autowiring::signal<void(const autowiring::CoreObjectDescriptor&)> newObject;
 
+  // Asserted after each runnable member of the context has been started, with the time taken to
+  // start it.  In parallel startup mode this signal may be asserted from more than one thread.
+  autowiring::signal<void(const autowiring::CoreObjectDescriptor&, std::chrono::nanoseconds)> runnableStarted;
+
   // The one and only configuration manager type
   autowiring::ConfigManager Config;
 
@@ -192,11 +211,20 @@ protected:
   // Child contexts:
   t_childList m_children;
 
+  // Incremented each time a child is introduced to or evicted from m_children
+  std::atomic<size_t> m_childrenVersion{0};
+
+  // The most recent copy of m_children made by GetChildSnapshot, accessed with atomic_load and atomic_store
+  mutable std::shared_ptr<const ChildSnapshot> m_childSnapshot;
+
   // Lists of event receivers, by name.  The type index of "void" is reserved for
   // bolts for all context types.
   typedef std::unordered_map<auto_id, std::vector<BoltBase*>> t_contextNameListeners;
   t_contextNameListeners m_nameListeners;
 
+  // Number of bolts added to this context, allows creation notices to pass over contexts without bolts
+  std::atomic<size_t> m_nBolts{0};
+
   /// \internal
   /// <summary>
   /// A proxy context member that knows how to create a factory for a particular type
@@ -219,6 +247,19 @@ protected:
   // This is a memoization map used to memoize any already-detected interfaces.
   mutable std::unordered_map<auto_id, autowiring::MemoEntry> m_typeMemos;
 
+  // Entries of m_typeMemos that have been resolved, so that repeated searches need not take the lock
+  mutable autowiring::MemoIndex m_memoIndex;
+
+  // The members of this context that implement each interface, indexed by interface.  Complete for
+  // the first m_nClassified interfaces in the TypeRelations registry, and also contains every member
+  // under its own type.
+  mutable std::unordered_multimap<auto_id, const autowiring::CoreObjectDescriptor*> m_implementors;
+  mutable size_t m_nClassified = 0;
+
+  // Entries of m_typeMemos whose type had no caster when the entry was created, and so could not be
+  // registered.  New members are tested against these individually.
+  mutable std::vector<autowiring::MemoEntry*> m_uncastMemos;
+
   // All known context members, exception filters:
   std::vector<ContextMember*> m_contextMembers;
   std::vector<ExceptionFilter*> m_filters;
@@ -235,6 +276,15 @@ protected:
   // Unlink flag
   bool m_unlinkOnTeardown = true;
 
+  // The maximum number of runnables started concurrently when the context enters the running state
+  size_t m_startupConcurrency = 1;
+
+  // The maximum number of child contexts shut down and released concurrently during shutdown
+  size_t m_teardownConcurrency = 1;
+
+  // Profiler notified of each phase of construction and startup in this context, may be null
+  std::shared_ptr<autowiring::ContextProfiler> m_profiler;
+
   // Creation rules are allowed to refer to private methods in this type
   template<autowiring::construction_strategy, class T, class... Args>
   friend struct autowiring::crh;
@@ -276,6 +326,8 @@ protected:
   /// <remarks>
   /// The broadcast is made without altering the current context.  Recipients expect that the current context will be the
   /// one about which they are being informed.
+  ///
+  /// Only the bolts registered for the specified sigil, and those registered for all sigils, are visited.
   /// </remarks>
   void BroadcastContextCreationNotice(auto_id sigil) const;
 
@@ -285,11 +337,25 @@ protected:
   /// </summary>
   void UpdateDeferredElement(std::unique_lock<std::mutex>&& lk, autowiring::MemoEntry& entry);
 
+  /// \internal
+  /// <summary>
+  /// Adds the specified member to m_implementors under each of the specified interfaces
+  /// </summary>
+  void IndexMemberUnsafe(const autowiring::CoreObjectDescriptor& desc, const std::vector<auto_id>& implemented) const;
+
+  /// \internal
+  /// <summary>
+  /// Brings m_implementors up to date with all interfaces registered so far
+  /// </summary>
+  void IndexMembersUnsafe(void) const;
+
   /// \internal
   /// <summary>
   /// Updates all deferred autowiring fields, generally called after a new member has been added
   /// </summary>
-  void UpdateDeferredElements(std::unique_lock<std::mutex>&& lk, const autowiring::CoreObjectDescriptor& entry, bool local);
+  /// <param name="lk">A lock on this context, which is released when this method returns</param>
+  /// <param name="implemented">The registered interfaces implemented by the new member</param>
+  void UpdateDeferredElements(std::unique_lock<std::mutex>&& lk, const autowiring::CoreObjectDescriptor& entry, const std::vector<auto_id>& implemented, bool local);
 
   /// \internal
   /// <summary>
@@ -365,6 +431,31 @@ protected:
   /// </summary>
   void TryTransitionChildrenState(void);
 
+  /// \internal
+  /// <summary>
+  /// Starts the runnables in m_threads from the specified position to the end of the list
+  /// </summary>
+  void StartRunnables(std::list<CoreRunnable*>::iterator first);
+
+  /// \internal
+  /// <summary>
+  /// Starts runnables concurrently, each one after the runnables it depends on
+  /// </summary>
+  void StartRunnablesParallel(
+    const std::vector<std::pair<CoreRunnable*, const autowiring::CoreObjectDescriptor*>>& runnables,
+    const std::shared_ptr<CoreObject>& outstanding
+  );
+
+  /// \internal
+  /// <summary>
+  /// Starts a single runnable and reports the time taken to do so
+  /// </summary>
+  void StartRunnable(
+    CoreRunnable& runnable,
+    const autowiring::CoreObjectDescriptor* pDesc,
+    const std::shared_ptr<CoreObject>& outstanding
+  );
+
   /// <summary>
   /// Registers a factory _function_, a lambda which is capable of constructing decltype(fn())
   /// </summary>
@@ -428,6 +519,16 @@ public:
   /// </summary>
   std::shared_ptr<CoreContext> NextSibling(void) const;
 
+  /// <summary>
+  /// A copy of the children of this context
+  /// </summary>
+  /// <remarks>
+  /// The copy is made under lock the first time it is requested after the set of children has changed,
+  /// and is otherwise shared without locking this context.  Children which have been destroyed since the
+  /// copy was made have expired entries.
+  /// </remarks>
+  std::shared_ptr<const ChildSnapshot> GetChildSnapshot(void) const;
+
   /// <summary>
   /// Gets the type information for the instance referenced by the specified shared pointer.
   /// </summary>
@@ -546,6 +647,57 @@ public:
     m_unlinkOnTeardown = unlinkOnTeardown;
   }
 
+  /// <summary>
+  /// Sets the maximum number of runnables this context starts at once
+  /// </summary>
+  /// <param name="nWorkers">The number of runnables, or zero for one per hardware thread</param>
+  /// <remarks>
+  /// By default, runnables are started one after another on the thread that causes the context to
+  /// enter the running state.  With a concurrency greater than one, they are instead started on a set
+  /// of worker threads, and a runnable is started only once every other runnable it holds an Autowired
+  /// or AutoRequired slot to has been started.  Runnables that depend on each other in a cycle are
+  /// started without regard to that cycle.  onRunning is asserted once all runnables have started.
+  ///
+  /// This mode is beneficial when members perform lengthy work in OnStart, such as loading files.  It
+  /// must be set before the context is initiated to have any effect.
+  /// </remarks>
+  void SetStartupConcurrency(size_t nWorkers) {
+    m_startupConcurrency = nWorkers ? nWorkers : std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  /// <summary>
+  /// Sets the maximum number of child contexts that this context shuts down at once
+  /// </summary>
+  /// <param name="nWorkers">The number of child contexts, or zero for one per hardware thread</param>
+  /// <remarks>
+  /// By default, SignalShutdown signals each child context in turn, and then releases the references
+  /// it took to those children one after another, on the calling thread.  With a concurrency greater
+  /// than one, both steps are instead performed on a set of worker threads.  A child context that
+  /// is not referenced elsewhere is then destroyed on one of those workers.
+  ///
+  /// Teardown order within each context is unchanged: a context is destroyed only after all of its
+  /// children, and it asserts expiredContext and then onTeardown before its members are destroyed.
+  /// Sibling contexts, however, may tear down concurrently, so handlers attached to more than one of
+  /// them must be thread safe.  This setting is not inherited by child contexts.
+  /// </remarks>
+  void SetTeardownConcurrency(size_t nWorkers) {
+    m_teardownConcurrency = nWorkers ? nWorkers : std::max(1U, std::thread::hardware_concurrency());
+  }
+  /// <summary>
+  /// Attaches a profiler to be notified of each phase of construction and startup in this context
+  /// </summary>
+  /// <remarks>
+  /// Contexts created as children of this context after this call inherit the profiler.  The profiler
+  /// should be attached before any members are added to the context; it is not synchronized with
+  /// concurrent injection.  See autowiring::dbg::ProfileStartup for a ready-made profiler.
+  /// </remarks>
+  void SetProfiler(const std::shared_ptr<autowiring::ContextProfiler>& profiler) {
+    m_profiler = profiler;
+  }
+
+  /// <returns>The profiler attached to this context, or nullptr if there is none</returns>
+  const std::shared_ptr<autowiring::ContextProfiler>& GetProfiler(void) const { return m_profiler; }
+
   /// \internal
   /// <summary>
   /// Scans the memo collection for the specified entry, or adds a deferred resolution marker if resolution was not possible
@@ -555,6 +707,10 @@ public:
   /// </returns>
   /// <param name="type">The type to be located</param>
   /// <param name="nonrecursive">False if ancestor contexts should not be searched</param>
+  /// <remarks>
+  /// Only the first search for a type in this context takes the context lock.  Later searches for the
+  /// same type return the memo entry created by the first search without synchronization.
+  /// </remarks>
   autowiring::MemoEntry& FindByType(auto_id type, bool nonrecursive = false) const;
 
   template<typename T>
@@ -595,9 +751,11 @@ public:
 
     // We must make ourselves current for the remainder of this call:
     CurrentContextPusher pshr(shared_from_this());
-    std::shared_ptr<typename CreationRules::TActual> retVal(
-      CreationRules::New(*this, std::forward<Args>(args)...)
-    );
+    std::shared_ptr<typename CreationRules::TActual> retVal;
+    {
+      autowiring::ProfileScope scope(m_profiler.get(), *this, autowiring::StartupPhase::Construct, auto_id_t<T>{});
+      retVal.reset(CreationRules::New(*this, std::forward<Args>(args)...));
+    }
     autowiring::CoreObjectDescriptor objDesc(retVal, (T*)nullptr);
 
     try {
@@ -623,6 +781,7 @@ public:
     try {
       // AutoInit if sensible to do so, we've proven to ourselves that we are the only owner
       // at this point
+      autowiring::ProfileScope scope(m_profiler.get(), *this, autowiring::StartupPhase::AutoInit, auto_id_t<T>{});
       CallAutoInit(*retVal, autowiring::has_autoinit<T>());
     }
     catch (...) {
@@ -13,6 +13,7 @@
 #include "ExceptionFilter.h"
 #include "fast_pointer_cast.h"
 #include "SlotInformation.h"
+#include "TypeRelations.h"
 #include <typeinfo>
 #include MEMORY_HEADER
 
@@ -59,7 +60,8 @@ struct CoreObjectDescriptor {
           reinterpret_cast<TActual*>(1)
         )
       ) - 1
-    )
+    ),
+    pRelations(pCoreObject ? &TypeRelations::For(typeid(*pCoreObject)) : nullptr)
   {
     // We can instantiate casts to CoreObject here at the point where object traits are being generated
     autowiring::instantiate<T>();
@@ -133,6 +135,10 @@ struct CoreObjectDescriptor {
 
   // Distance from TActual to T
   size_t primitiveOffset;
+
+  // The interfaces known to be implemented by the concrete class of this object, or nullptr if the
+  // object is not a CoreObject.  Interfaces are resolved against the object through this index.
+  TypeRelations* pRelations;
 };
 
 }
@@ -0,0 +1,68 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "DecorationArena.h"
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+using namespace autowiring;
+
+const size_t DecorationArena::PageSize;
+
+// Offset of the first usable byte in a page, keeps the page header maximally aligned
+static const size_t sc_headerSize = (sizeof(void*) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+DecorationArena::~DecorationArena(void) {
+  for (Page* pNext; m_pHead; m_pHead = pNext) {
+    pNext = m_pHead->pFlink;
+    ::operator delete(m_pHead);
+  }
+}
+
+void DecorationArena::Unref(void) {
+  if (m_live.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    delete this;
+}
+
+void* DecorationArena::Allocate(size_t size, size_t align) {
+  m_live.fetch_add(1, std::memory_order_relaxed);
+
+  std::lock_guard<autowiring::spin_lock> lk(m_lock);
+  if (size > PageSize / 2) {
+    // Oversized, give this allocation a page of its own and link it behind the current page so
+    // that bump allocation can continue where it left off
+    Page* page = static_cast<Page*>(::operator new(sc_headerSize + size + align));
+    m_reserved += sc_headerSize + size + align;
+    if (m_pHead) {
+      page->pFlink = m_pHead->pFlink;
+      m_pHead->pFlink = page;
+    }
+    else {
+      page->pFlink = nullptr;
+      m_pHead = page;
+    }
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(page) + sc_headerSize;
+    return reinterpret_cast<void*>((base + align - 1) & ~(uintptr_t)(align - 1));
+  }
+
+  uintptr_t cur = (reinterpret_cast<uintptr_t>(m_pCur) + align - 1) & ~(uintptr_t)(align - 1);
+  if (!m_pCur || cur + size > reinterpret_cast<uintptr_t>(m_pEnd)) {
+    // Current page exhausted, start a new one
+    Page* page = static_cast<Page*>(::operator new(PageSize));
+    m_reserved += PageSize;
+    page->pFlink = m_pHead;
+    m_pHead = page;
+    m_pCur = reinterpret_cast<char*>(page) + sc_headerSize;
+    m_pEnd = reinterpret_cast<char*>(page) + PageSize;
+    cur = (reinterpret_cast<uintptr_t>(m_pCur) + align - 1) & ~(uintptr_t)(align - 1);
+  }
+
+  m_pCur = reinterpret_cast<char*>(cur + size);
+  return reinterpret_cast<void*>(cur);
+}
+
+size_t DecorationArena::GetReservedBytes(void) {
+  std::lock_guard<autowiring::spin_lock> lk(m_lock);
+  return m_reserved;
+}
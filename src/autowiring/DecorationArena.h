@@ -0,0 +1,113 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "spin_lock.h"
+#include <atomic>
+#include <cstddef>
+
+namespace autowiring {
+
+/// <summary>
+/// A bump allocator used to hold the decorations attached to a single AutoPacket
+/// </summary>
+/// <remarks>
+/// Decorations are constructed back-to-back in fixed-size pages, together with their shared pointer
+/// control blocks, so that decorating a packet does not require a trip to the heap.  Individual
+/// deallocations do not return memory to the arena; they only decrement a count of live allocations.
+/// All pages are released together once the owning packet has called Release and the last allocation
+/// made from this arena has been returned.  This permits shared pointers obtained through GetShared
+/// to safely outlive the packet that created them.
+/// </remarks>
+class DecorationArena {
+public:
+  DecorationArena(void) = default;
+  DecorationArena(const DecorationArena&) = delete;
+
+  // Size of a single page.  Allocations larger than half of this size are given a dedicated page.
+  static const size_t PageSize = 4096;
+
+private:
+  ~DecorationArena(void);
+
+  struct Page {
+    Page* pFlink;
+  };
+
+  // Lock guarding the bump pointer and page list:
+  autowiring::spin_lock m_lock;
+
+  // Live allocation count, plus one for the owner of the arena:
+  std::atomic<size_t> m_live{1};
+
+  // Head of the page list, the first page is the one currently being bumped:
+  Page* m_pHead = nullptr;
+
+  // Bump pointer and limit within the current page:
+  char* m_pCur = nullptr;
+  char* m_pEnd = nullptr;
+
+  // Total number of bytes held by all pages:
+  size_t m_reserved = 0;
+
+  // Decrements the live count, and frees the arena when it reaches zero
+  void Unref(void);
+
+public:
+  /// <summary>
+  /// Allocates a block of the requested size and alignment from the arena
+  /// </summary>
+  void* Allocate(size_t size, size_t align);
+
+  /// <summary>
+  /// Returns a block to the arena
+  /// </summary>
+  /// <remarks>
+  /// Memory is not recycled until the arena itself is freed
+  /// </remarks>
+  void Deallocate(void*) { Unref(); }
+
+  /// <summary>
+  /// Releases the owner's hold on this arena
+  /// </summary>
+  /// <remarks>
+  /// The arena will be freed when all outstanding allocations have also been returned.  The caller
+  /// must not make further use of this arena after calling this method.
+  /// </remarks>
+  void Release(void) { Unref(); }
+
+  /// <returns>The total number of bytes currently reserved by this arena's pages</returns>
+  size_t GetReservedBytes(void);
+
+  /// <summary>
+  /// Minimal allocator for use with std::allocate_shared
+  /// </summary>
+  template<class T>
+  struct allocator {
+    typedef T value_type;
+
+    allocator(DecorationArena& arena) : arena(&arena) {}
+
+    template<class U>
+    allocator(const allocator<U>& rhs) : arena(rhs.arena) {}
+
+    DecorationArena* arena;
+
+    T* allocate(size_t n) {
+      return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+      arena->Deallocate(p);
+    }
+
+    template<class U>
+    bool operator==(const allocator<U>& rhs) const { return arena == rhs.arena; }
+
+    template<class U>
+    bool operator!=(const allocator<U>& rhs) const { return arena != rhs.arena; }
+  };
+
+  template<class T>
+  allocator<T> get_allocator(void) { return allocator<T>(*this); }
+};
+
+}
@@ -4,7 +4,9 @@
 #include "altitude.h"
 #include "AnySharedPointer.h"
 #include <atomic>
+#include <cstdint>
 #include <set>
+#include <stdexcept>
 #include <vector>
 
 namespace autowiring {
@@ -145,6 +147,10 @@ struct DecorationDisposition
   // The current state of this disposition
   DispositionState m_state = DispositionState::Unsatisfied;
 
+  // Timeshifts at which this decoration is consumed by a later packet.  Bit N is set if some filter
+  // takes this decoration as a prior from N packets ago.  Only maintained on untimeshifted entries.
+  uint64_t m_timeshifts = 0;
+
   /// <summary>
   /// Increments the number of producers run by one
   /// </summary>
@@ -0,0 +1,51 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "AutoFilterDescriptor.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include MEMORY_HEADER
+#include <vector>
+
+namespace autowiring {
+
+/// <summary>
+/// An immutable version of the set of AutoFilters registered with an AutoPacketFactory
+/// </summary>
+/// <remarks>
+/// Every change to the factory's subscribers publishes a new version, built from a copy of the prior
+/// one.  Each packet pins the version that was current when it was issued and configures itself from
+/// that version alone, so subscribers may be added and removed concurrently with packet issue.
+/// </remarks>
+struct FilterGraph {
+  // Incremented each time a version is published, the first version with any filters is 1
+  uint64_t version = 0;
+
+  // The registered filters, in the order defined by AutoFilterDescriptor::operator<
+  std::vector<AutoFilterDescriptor> filters;
+
+  // The number of times each filter was skipped on packets past their deadline, parallel to filters and
+  // null for filters which are not skippable.  Counters are shared between versions, so counts
+  // accumulate across subscriber changes, and each packet's pinned version keeps them alive.
+  std::vector<std::shared_ptr<std::atomic<uint64_t>>> skipCounts;
+
+  // True if any filter takes a timeshifted input
+  bool timeshifted = false;
+
+  /// <returns>True if the specified filter is a member of this version</returns>
+  bool contains(const AutoFilterDescriptor& filter) const {
+    auto q = std::lower_bound(filters.begin(), filters.end(), filter);
+    return q != filters.end() && *q == filter;
+  }
+
+  /// <returns>True if the specified filter takes a timeshifted input</returns>
+  static bool is_timeshifted(const AutoFilterDescriptor& filter) {
+    const auto* args = filter.GetAutoFilterArguments();
+    for (size_t i = filter.GetArity(); i--;)
+      if (args[i].tshift)
+        return true;
+    return false;
+  }
+};
+
+}
@@ -0,0 +1,133 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "ForEachConcurrently.h"
+#include "CoreContext.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include MUTEX_HEADER
+#include THREAD_HEADER
+
+namespace {
+  // Collects the first exception thrown by any worker
+  struct FirstException {
+    std::mutex lock;
+    std::exception_ptr ex;
+
+    void Capture(void) {
+      std::lock_guard<std::mutex> lk(lock);
+      if (!ex)
+        ex = std::current_exception();
+    }
+
+    void Rethrow(void) {
+      if (ex)
+        std::rethrow_exception(ex);
+    }
+  };
+
+  // Runs worker on nWorkers threads, one of which is the calling thread, all with the calling thread's
+  // current context.  The worker must not throw.
+  void RunWorkers(size_t nWorkers, const std::function<void()>& worker) {
+    auto current = CoreContext::CurrentContext();
+    auto run = [&] {
+      CurrentContextPusher pshr(current);
+      worker();
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < nWorkers; i++)
+      workers.emplace_back(run);
+    run();
+    for (auto& cur : workers)
+      cur.join();
+  }
+}
+
+void autowiring::ForEachConcurrently(size_t n, size_t nWorkers, const std::function<void(size_t)>& fn) {
+  std::atomic<size_t> next{0};
+  FirstException ex;
+
+  RunWorkers(
+    std::min(n, nWorkers),
+    [&] {
+      for (size_t i; (i = next++) < n;)
+        try {
+          fn(i);
+        }
+        catch (...) {
+          ex.Capture();
+        }
+    }
+  );
+  ex.Rethrow();
+}
+
+void autowiring::ForEachConcurrently(size_t n, size_t nWorkers, std::vector<std::vector<size_t>> dependents, const std::function<void(size_t)>& fn) {
+  std::vector<size_t> nDepends(n);
+  for (const auto& list : dependents)
+    for (size_t dependent : list)
+      nDepends[dependent]++;
+
+  // Any index which cannot be ordered because it lies on or after a cycle is released from its
+  // dependencies.  Ordering is determined here so that workers never wait on a cycle.
+  {
+    std::vector<size_t> remaining = nDepends;
+    std::vector<size_t> order;
+    for (size_t i = 0; i < n; i++)
+      if (!remaining[i])
+        order.push_back(i);
+    for (size_t i = 0; i < order.size(); i++)
+      for (size_t dependent : dependents[order[i]])
+        if (!--remaining[dependent])
+          order.push_back(dependent);
+
+    if (order.size() != n) {
+      for (size_t i = 0; i < n; i++)
+        if (remaining[i]) {
+          nDepends[i] = 0;
+          for (auto& list : dependents)
+            list.erase(std::remove(list.begin(), list.end(), i), list.end());
+        }
+    }
+  }
+
+  std::mutex lock;
+  std::condition_variable cv;
+  std::vector<size_t> ready;
+  size_t nOutstanding = n;
+  FirstException ex;
+  for (size_t i = 0; i < n; i++)
+    if (!nDepends[i])
+      ready.push_back(i);
+
+  RunWorkers(
+    std::min(n, nWorkers),
+    [&] {
+      std::unique_lock<std::mutex> lk(lock);
+      for (;;) {
+        cv.wait(lk, [&] { return !ready.empty() || !nOutstanding; });
+        if (ready.empty())
+          return;
+
+        size_t i = ready.back();
+        ready.pop_back();
+        lk.unlock();
+        try {
+          fn(i);
+        }
+        catch (...) {
+          ex.Capture();
+        }
+        lk.lock();
+
+        nOutstanding--;
+        for (size_t dependent : dependents[i])
+          if (!--nDepends[dependent])
+            ready.push_back(dependent);
+        cv.notify_all();
+      }
+    }
+  );
+  ex.Rethrow();
+}
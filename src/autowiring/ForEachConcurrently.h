@@ -0,0 +1,25 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include FUNCTIONAL_HEADER
+#include <vector>
+
+namespace autowiring {
+  /// <summary>
+  /// Invokes fn for each index in [0, n) on up to nWorkers threads, one of which is the calling thread
+  /// </summary>
+  /// <remarks>
+  /// Workers run with the calling thread's current context.  The first exception thrown by fn is
+  /// rethrown once all indexes have been processed.
+  /// </remarks>
+  void ForEachConcurrently(size_t n, size_t nWorkers, const std::function<void(size_t)>& fn);
+
+  /// <summary>
+  /// Invokes fn for each index in [0, n) on up to nWorkers threads, each index after those it depends on
+  /// </summary>
+  /// <param name="dependents">For each index, the indexes which may only be processed after it</param>
+  /// <remarks>
+  /// Indexes which cannot be ordered because they lie on or after a dependency cycle are released from
+  /// their dependencies rather than waiting forever.  Otherwise identical to the unordered overload.
+  /// </remarks>
+  void ForEachConcurrently(size_t n, size_t nWorkers, std::vector<std::vector<size_t>> dependents, const std::function<void(size_t)>& fn);
+}
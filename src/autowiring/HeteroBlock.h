@@ -2,6 +2,7 @@
 #pragma once
 #include "auto_id.h"
 #include <initializer_list>
+#include <stdexcept>
 #include <unordered_map>
 #include <vector>
 
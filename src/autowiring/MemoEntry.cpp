@@ -6,3 +6,29 @@ using namespace autowiring;
 
 
 MemoEntry::MemoEntry(void) {}
+
+MemoIndex::MemoIndex(void) {
+  for (auto& block : m_blocks)
+    block.store(nullptr, std::memory_order_relaxed);
+}
+
+MemoIndex::~MemoIndex(void) {
+  for (auto& block : m_blocks)
+    delete block.load(std::memory_order_relaxed);
+}
+
+void MemoIndex::Publish(auto_id type, MemoEntry& entry) {
+  size_t index = std::hash<auto_id>()(type);
+  if (!index || index >= BlockSize * BlockCount)
+    return;
+
+  auto& slot = m_blocks[index / BlockSize];
+  Block* block = slot.load(std::memory_order_relaxed);
+  if (!block) {
+    block = new Block;
+    for (auto& e : block->entries)
+      e.store(nullptr, std::memory_order_relaxed);
+    slot.store(block, std::memory_order_release);
+  }
+  block->entries[index % BlockSize].store(&entry, std::memory_order_release);
+}
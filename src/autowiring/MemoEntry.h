@@ -2,6 +2,7 @@
 #pragma once
 #include "AnySharedPointer.h"
 #include "once.h"
+#include <atomic>
 
 class CoreContext;
 
@@ -33,4 +34,47 @@ struct MemoEntry {
   bool m_local = true;
 };
 
+/// \internal
+/// <summary>
+/// A table of memo entries indexed by the index of their auto_id, readable without locking
+/// </summary>
+/// <remarks>
+/// Entries are published once they have been fully resolved, and a published entry is never removed
+/// from the table.  Publication must be externally synchronized, but Find may be called concurrently
+/// with Publish from any thread.  The table is divided into fixed-size blocks which are allocated when
+/// the first entry in that block is published, so that a context which resolves only a few types pays
+/// for only a few blocks.  Types whose index lies beyond the capacity of the table cannot be published.
+/// </remarks>
+class MemoIndex {
+public:
+  MemoIndex(void);
+  MemoIndex(const MemoIndex&) = delete;
+  ~MemoIndex(void);
+
+  static const size_t BlockSize = 256;
+  static const size_t BlockCount = 64;
+
+private:
+  struct Block {
+    std::atomic<MemoEntry*> entries[BlockSize];
+  };
+  std::atomic<Block*> m_blocks[BlockCount];
+
+public:
+  /// <returns>The published entry for the specified type, or nullptr if there is none</returns>
+  MemoEntry* Find(auto_id type) const {
+    size_t index = std::hash<auto_id>()(type);
+    if (index >= BlockSize * BlockCount)
+      return nullptr;
+
+    Block* block = m_blocks[index / BlockSize].load(std::memory_order_acquire);
+    return block ? block->entries[index % BlockSize].load(std::memory_order_acquire) : nullptr;
+  }
+
+  /// <summary>
+  /// Makes the specified entry available to Find
+  /// </summary>
+  void Publish(auto_id type, MemoEntry& entry);
+};
+
 }
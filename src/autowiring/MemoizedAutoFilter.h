@@ -0,0 +1,241 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "auto_id.h"
+#include "marshaller.h"
+#include "StaticPipeline.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include MUTEX_HEADER
+#include <string>
+#include <tuple>
+#include STL_UNORDERED_MAP
+
+namespace autowiring {
+  /// <summary>
+  /// Hash used by MemoizedAutoFilter to identify the inputs of a call
+  /// </summary>
+  /// <remarks>
+  /// The default hashes the string form produced by the type's marshaller, which is available for all
+  /// builtin types.  Specialize this template to memoize filters with inputs of other types.
+  /// </remarks>
+  template<typename T, typename = void>
+  struct memo_hash {
+    static_assert(
+      !std::is_base_of<invalid_marshal_base, marshaller<T>>::value,
+      "Type T has neither a marshaller nor a memo_hash specialization"
+    );
+
+    size_t operator()(const T& value) const {
+      return std::hash<std::string>()(marshaller<T>().marshal(&value));
+    }
+  };
+
+  /// <summary>
+  /// Cache statistics for a single memoized AutoFilter
+  /// </summary>
+  struct MemoStatistics {
+    // The type of the memoized filter
+    auto_id type;
+
+    // Calls answered from the cache, and calls which invoked the filter
+    uint64_t hits;
+    uint64_t misses;
+
+    // Entries discarded to keep the cache within its capacity
+    uint64_t evictions;
+
+    // Current and maximum number of cached entries
+    size_t size;
+    size_t capacity;
+
+    double hitRate(void) const {
+      return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0;
+    }
+  };
+
+  namespace detail {
+    /// <summary>
+    /// Bounded least-recently-used cache of the outputs of a filter, keyed by its inputs
+    /// </summary>
+    /// <remarks>
+    /// Params is the list of the filter's argument types, used to locate each input and output among
+    /// the pointers to those arguments.  The cache is not synchronized.
+    /// </remarks>
+    template<class Inputs, class Outputs, class Params>
+    class memo_cache;
+
+    template<class... Inputs, class... Outputs, class... Params>
+    class memo_cache<pipeline_list<Inputs...>, pipeline_list<Outputs...>, pipeline_list<Params...>> {
+    public:
+      memo_cache(size_t capacity) :
+        m_capacity(capacity ? capacity : 1)
+      {}
+
+    private:
+      struct Entry {
+        size_t hash;
+        std::tuple<Inputs...> inputs;
+        std::tuple<Outputs...> outputs;
+      };
+
+      const size_t m_capacity;
+
+      // Entries in order of use, most recent first, and an index of those entries by hash
+      std::list<Entry> m_entries;
+      std::unordered_multimap<size_t, typename std::list<Entry>::iterator> m_index;
+
+      // The argument of type T
+      template<class T, class Ptrs>
+      static auto arg(const Ptrs& ptrs) -> decltype(*std::get<pipeline_index<pipeline_list<Params...>, T>::value>(ptrs)) {
+        return *std::get<pipeline_index<pipeline_list<Params...>, T>::value>(ptrs);
+      }
+
+    public:
+      size_t size(void) const { return m_entries.size(); }
+      size_t capacity(void) const { return m_capacity; }
+
+      template<class Ptrs>
+      static size_t Hash(const Ptrs& ptrs) {
+        size_t retVal = 0;
+        int order[] = {0, (retVal ^= memo_hash<Inputs>()(arg<Inputs>(ptrs)) + 0x9e3779b9 + (retVal << 6) + (retVal >> 2), 0)...};
+        (void)order;
+        return retVal;
+      }
+
+      /// <summary>
+      /// Assigns the cached outputs for the specified inputs, if present
+      /// </summary>
+      /// <returns>True if the outputs were found</returns>
+      template<class Ptrs>
+      bool Find(size_t hash, const Ptrs& ptrs) {
+        auto range = m_index.equal_range(hash);
+        for (auto q = range.first; q != range.second; q++) {
+          Entry& entry = *q->second;
+          if (!(std::tie(arg<Inputs>(ptrs)...) == entry.inputs))
+            continue;
+
+          std::tie(arg<Outputs>(ptrs)...) = entry.outputs;
+          m_entries.splice(m_entries.begin(), m_entries, q->second);
+          return true;
+        }
+        return false;
+      }
+
+      /// <summary>
+      /// Caches the outputs computed for the specified inputs
+      /// </summary>
+      /// <returns>True if an older entry was evicted to make room</returns>
+      template<class Ptrs>
+      bool Insert(size_t hash, const Ptrs& ptrs) {
+        m_entries.push_front(Entry{hash, std::make_tuple(arg<Inputs>(ptrs)...), std::make_tuple(arg<Outputs>(ptrs)...)});
+        m_index.insert(std::make_pair(hash, m_entries.begin()));
+        if (m_entries.size() <= m_capacity)
+          return false;
+
+        auto last = std::prev(m_entries.end());
+        auto range = m_index.equal_range(last->hash);
+        for (auto q = range.first; q != range.second; q++)
+          if (q->second == last) {
+            m_index.erase(q);
+            break;
+          }
+        m_entries.pop_back();
+        return true;
+      }
+    };
+
+    // Maps const and non-const AutoFilter member functions to the same signature
+    template<class MemFn>
+    struct memo_signature {
+      typedef MemFn type;
+    };
+
+    template<class W, class... Args>
+    struct memo_signature<void (W::*)(Args...) const> {
+      typedef void (W::*type)(Args...);
+    };
+  }
+}
+
+template<class F, class MemFn = typename autowiring::detail::memo_signature<decltype(&F::AutoFilter)>::type>
+class MemoizedAutoFilter;
+
+/// <summary>
+/// Adapts a filter whose outputs depend only on its inputs so that repeated inputs are served from a cache
+/// </summary>
+/// <remarks>
+/// Add MemoizedAutoFilter&lt;F&gt; to a context in place of F.  Each call hashes the inputs of F with
+/// autowiring::memo_hash and looks them up among the most recent distinct inputs seen.  On a hit, the
+/// cached outputs are copied to the packet and F::AutoFilter is not called.  On a miss, F::AutoFilter is
+/// called and its outputs are cached, displacing the least recently used entry if the cache is full.
+///
+/// F must take its inputs by value or const reference and its outputs by reference.  Inputs must be
+/// copyable and comparable with operator==, and outputs must be copyable.  Calls on different packets
+/// may proceed concurrently; only the cache itself is locked.
+/// </remarks>
+template<class F, class W, class... Args>
+class MemoizedAutoFilter<F, void (W::*)(Args...)>:
+  public F
+{
+public:
+  MemoizedAutoFilter(void) :
+    m_cache(16)
+  {}
+
+  /// <param name="capacity">The maximum number of distinct inputs to be remembered</param>
+  /// <param name="args">Arguments passed to the constructor of F</param>
+  template<class... Ts>
+  explicit MemoizedAutoFilter(size_t capacity, Ts&&... args) :
+    F(std::forward<Ts>(args)...),
+    m_cache(capacity)
+  {}
+
+private:
+  typedef autowiring::detail::pipeline_classify<autowiring::detail::pipeline_list<>, autowiring::detail::pipeline_list<>, Args...> t_signature;
+
+  std::mutex m_lock;
+  autowiring::detail::memo_cache<
+    typename t_signature::inputs,
+    typename t_signature::outputs,
+    autowiring::detail::pipeline_list<typename autowiring::detail::pipeline_arg<Args>::type...>
+  > m_cache;
+
+  std::atomic<uint64_t> m_hits{0};
+  std::atomic<uint64_t> m_misses{0};
+  std::atomic<uint64_t> m_evictions{0};
+
+public:
+  /// <returns>The cache statistics of this filter</returns>
+  autowiring::MemoStatistics GetMemoStatistics(void) {
+    autowiring::MemoStatistics retVal;
+    retVal.type = auto_id_t<F>{};
+    retVal.hits = m_hits;
+    retVal.misses = m_misses;
+    retVal.evictions = m_evictions;
+    retVal.capacity = m_cache.capacity();
+    std::lock_guard<std::mutex>{m_lock},
+    retVal.size = m_cache.size();
+    return retVal;
+  }
+
+  void AutoFilter(Args... args) {
+    auto ptrs = std::make_tuple(&args...);
+    size_t hash = m_cache.Hash(ptrs);
+    {
+      std::lock_guard<std::mutex> lk(m_lock);
+      if (m_cache.Find(hash, ptrs)) {
+        ++m_hits;
+        return;
+      }
+    }
+
+    // Not cached, the filter proper is called without holding the lock
+    ++m_misses;
+    F::AutoFilter(args...);
+
+    std::lock_guard<std::mutex> lk(m_lock);
+    if (m_cache.Insert(hash, ptrs))
+      ++m_evictions;
+  }
+};
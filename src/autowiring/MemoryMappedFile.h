@@ -0,0 +1,39 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace autowiring {
+  /// <summary>
+  /// A read-only view of an entire file, mapped into the address space of this process
+  /// </summary>
+  /// <remarks>
+  /// The constructor throws autowiring_error if the file cannot be opened or mapped.  An empty file
+  /// is mapped as a null view of zero size.
+  /// </remarks>
+  class MemoryMappedFile {
+  public:
+    MemoryMappedFile(const std::string& path);
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    ~MemoryMappedFile(void);
+
+    void operator=(const MemoryMappedFile&) = delete;
+
+  private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+
+    // Platform handles for the file and its mapping object, unused on platforms which do not need
+    // them once the view is established
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+
+  public:
+    /// <returns>The first byte of the mapped view</returns>
+    const uint8_t* data(void) const { return m_data; }
+
+    /// <returns>The size of the mapped view, in bytes</returns>
+    size_t size(void) const { return m_size; }
+  };
+}
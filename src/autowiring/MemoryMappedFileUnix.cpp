@@ -0,0 +1,40 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "MemoryMappedFile.h"
+#include "autowiring_error.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace autowiring;
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw autowiring_error("Failed to open " + path + " for mapping");
+
+  struct stat st;
+  if (fstat(fd, &st)) {
+    close(fd);
+    throw autowiring_error("Failed to obtain the size of " + path);
+  }
+
+  m_size = static_cast<size_t>(st.st_size);
+  if (m_size) {
+    void* view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+      close(fd);
+      throw autowiring_error("Failed to map " + path);
+    }
+    m_data = static_cast<const uint8_t*>(view);
+  }
+
+  // The mapping remains valid after the descriptor is closed
+  close(fd);
+}
+
+MemoryMappedFile::~MemoryMappedFile(void) {
+  if (m_data)
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+}
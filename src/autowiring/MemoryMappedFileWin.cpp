@@ -0,0 +1,50 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "MemoryMappedFile.h"
+#include "autowiring_error.h"
+#include <Windows.h>
+
+using namespace autowiring;
+
+MemoryMappedFile::MemoryMappedFile(const std::string& path) {
+  HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (hFile == INVALID_HANDLE_VALUE)
+    throw autowiring_error("Failed to open " + path + " for mapping");
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(hFile, &size)) {
+    CloseHandle(hFile);
+    throw autowiring_error("Failed to obtain the size of " + path);
+  }
+
+  m_file = hFile;
+  m_size = static_cast<size_t>(size.QuadPart);
+  if (!m_size)
+    // Zero-length files cannot be mapped
+    return;
+
+  HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!hMapping) {
+    CloseHandle(hFile);
+    throw autowiring_error("Failed to create a mapping of " + path);
+  }
+
+  void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(hMapping);
+    CloseHandle(hFile);
+    throw autowiring_error("Failed to map " + path);
+  }
+
+  m_mapping = hMapping;
+  m_data = static_cast<const uint8_t*>(view);
+}
+
+MemoryMappedFile::~MemoryMappedFile(void) {
+  if (m_data)
+    UnmapViewOfFile(m_data);
+  if (m_mapping)
+    CloseHandle(m_mapping);
+  if (m_file)
+    CloseHandle(m_file);
+}
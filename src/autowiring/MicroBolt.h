@@ -17,22 +17,14 @@ template<typename T, typename... Sigils>
 struct MicroBolt:
   public Bolt<Sigils...>
 {
-private:
-  template<class W>
-  static bool LoopInject(const std::shared_ptr<CoreContext>& ctxt) {
-    for(auto context : ContextEnumeratorT<W>(ctxt))
-      // Inject<W>() is idempotent, that makes this behavior safe
-      context->template Inject<T>();
-    return true;
-  }
-
 public:
   MicroBolt(void) {
-    // NOTE: Injection of T into all matching contexts may result in
-    // multiple calls to Inject<T>() if a matching context
-    // is created during traversal.
+    // Matching contexts which already exist beneath this one are bolted by the context once
+    // this bolt has been added, only the context where it is being added is handled here.
+    // Inject<T>() is idempotent, so a context seen twice is harmless.
     const auto ctxt = CoreContext::CurrentContext();
-    autowiring::noop(LoopInject<Sigils>(ctxt)...);
+    if (Bolt<Sigils...>::Matches(ctxt->GetSigilType()))
+      ctxt->template Inject<T>();
   }
   void ContextCreated(void) override;
 };
@@ -1,9 +1,12 @@
 // Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
 #pragma once
 #include "AutoFilterDescriptor.h"
+#include <atomic>
 
 namespace autowiring {
 
+struct AutoFilterProfile;
+
 /// <summary>
 /// A single subscription counter entry
 /// </summary>
@@ -19,7 +22,9 @@ struct SatCounter:
 
   SatCounter(const SatCounter& source):
     AutoFilterDescriptor(static_cast<const AutoFilterDescriptor&>(source)),
-    remaining(source.remaining)
+    remaining(source.remaining),
+    profile(source.profile),
+    skipCount(source.skipCount)
   {}
 
   // Forward and backward linked list pointers
@@ -29,6 +34,14 @@ struct SatCounter:
   // The number of inputs remaining to this counter:
   size_t remaining = 0;
 
+  // Execution statistics for this filter, or nullptr if the factory is not profiling filters.  Shared
+  // with the factory, so that the profile outlives the factory's record of a removed filter.
+  std::shared_ptr<AutoFilterProfile> profile;
+
+  // The number of times this filter was skipped past a packet's deadline, owned by the filter graph
+  // pinned by the packet.  nullptr if the filter is not skippable or is not part of that graph.
+  std::atomic<uint64_t>* skipCount = nullptr;
+
   /// <summary>
   /// Conditionally decrements AutoFilter argument satisfaction.
   /// </summary>
@@ -0,0 +1,363 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "auto_arg.h"
+#include "index_tuple.h"
+#include "is_any.h"
+#include <tuple>
+#include TYPE_TRAITS_HEADER
+
+class AutoPacket;
+
+namespace autowiring {
+namespace detail {
+  /// <summary>
+  /// A compile-time list of types, used to describe the dataflow of a static pipeline
+  /// </summary>
+  template<class... Ts>
+  struct pipeline_list {
+    static const size_t N = sizeof...(Ts);
+  };
+
+  template<class T>
+  struct pipeline_always_false {
+    static const bool value = false;
+  };
+
+  template<class List, class T>
+  struct pipeline_contains;
+
+  template<class... Ts, class T>
+  struct pipeline_contains<pipeline_list<Ts...>, T> {
+    static const bool value = is_any_same<T, Ts...>::value;
+  };
+
+  // True if every member of Sub is also a member of List
+  template<class List, class Sub>
+  struct pipeline_includes;
+
+  template<class List, class... Us>
+  struct pipeline_includes<List, pipeline_list<Us...>> {
+    static const bool value = !is_any<!pipeline_contains<List, Us>::value...>::value;
+  };
+
+  // Appends T to List if it is not already a member
+  template<class List, class T>
+  struct pipeline_insert;
+
+  template<class... Ts, class T>
+  struct pipeline_insert<pipeline_list<Ts...>, T> {
+    typedef typename std::conditional<
+      is_any_same<T, Ts...>::value,
+      pipeline_list<Ts...>,
+      pipeline_list<Ts..., T>
+    >::type type;
+  };
+
+  // Members of List followed by any members of Other that are not already in List
+  template<class List, class Other>
+  struct pipeline_union {
+    typedef List type;
+  };
+
+  template<class List, class U, class... Us>
+  struct pipeline_union<List, pipeline_list<U, Us...>>:
+    pipeline_union<typename pipeline_insert<List, U>::type, pipeline_list<Us...>>
+  {};
+
+  // Members of List which are not members of Other, in their original order
+  template<class List, class Other>
+  struct pipeline_difference {
+    typedef pipeline_list<> type;
+  };
+
+  template<class T, class... Ts, class Other>
+  struct pipeline_difference<pipeline_list<T, Ts...>, Other> {
+    typedef typename pipeline_difference<pipeline_list<Ts...>, Other>::type rest;
+
+    template<class Rest>
+    struct prepend;
+
+    template<class... Rs>
+    struct prepend<pipeline_list<Rs...>> {
+      typedef pipeline_list<T, Rs...> type;
+    };
+
+    typedef typename std::conditional<
+      pipeline_contains<Other, T>::value,
+      rest,
+      typename prepend<rest>::type
+    >::type type;
+  };
+
+  // The position of T in List
+  template<class List, class T>
+  struct pipeline_index;
+
+  template<class T, class... Ts>
+  struct pipeline_index<pipeline_list<T, Ts...>, T> {
+    static const int value = 0;
+  };
+
+  template<class U, class... Ts, class T>
+  struct pipeline_index<pipeline_list<U, Ts...>, T> {
+    static const int value = 1 + pipeline_index<pipeline_list<Ts...>, T>::value;
+  };
+
+  /// <summary>
+  /// Classifies a single AutoFilter argument for use in a static pipeline
+  /// </summary>
+  /// <remarks>
+  /// Only the plain forms are supported: inputs by value or by const reference, and outputs by
+  /// reference.  Optional, multi, rvalue and timeshifted arguments all depend on run-time state which
+  /// a static pipeline does not track.
+  /// </remarks>
+  template<class Arg>
+  struct pipeline_arg {
+    typedef typename std::decay<Arg>::type type;
+
+    static const bool is_output =
+      std::is_lvalue_reference<Arg>::value &&
+      !std::is_const<typename std::remove_reference<Arg>::type>::value;
+    static const bool is_input = !is_output;
+
+    static const bool supported =
+      !std::is_rvalue_reference<Arg>::value &&
+      !std::is_same<type, AutoPacket>::value &&
+      std::is_same<typename auto_arg<Arg>::id_type, auto_id_t<type>>::value &&
+      !auto_arg<Arg>::is_shared &&
+      !auto_arg<Arg>::is_multi &&
+      !auto_arg<Arg>::tshift;
+  };
+
+  // Accumulates the distinct input and output types of an argument list
+  template<class Inputs, class Outputs, class... Args>
+  struct pipeline_classify {
+    typedef Inputs inputs;
+    typedef Outputs outputs;
+  };
+
+  template<class Inputs, class Outputs, class Arg, class... Args>
+  struct pipeline_classify<Inputs, Outputs, Arg, Args...>:
+    pipeline_classify<
+      typename std::conditional<
+        pipeline_arg<Arg>::is_input,
+        typename pipeline_insert<Inputs, typename pipeline_arg<Arg>::type>::type,
+        Inputs
+      >::type,
+      typename std::conditional<
+        pipeline_arg<Arg>::is_output,
+        typename pipeline_insert<Outputs, typename pipeline_arg<Arg>::type>::type,
+        Outputs
+      >::type,
+      Args...
+    >
+  {
+    static_assert(
+      pipeline_arg<Arg>::supported,
+      "Static pipeline filters may only take inputs by value or const reference, and outputs by reference"
+    );
+  };
+
+  template<class MemFn>
+  struct pipeline_signature;
+
+  template<class W, class... Args>
+  struct pipeline_signature<void (W::*)(Args...)>:
+    pipeline_classify<pipeline_list<>, pipeline_list<>, Args...>
+  {
+    // Invokes the filter with its arguments drawn from the specified decoration store
+    template<class Decorations, class Store>
+    static void Call(W& filter, Store& store) {
+      filter.AutoFilter(*std::get<pipeline_index<Decorations, typename pipeline_arg<Args>::type>::value>(store)...);
+    }
+  };
+
+  template<class W, class... Args>
+  struct pipeline_signature<void (W::*)(Args...) const>:
+    pipeline_signature<void (W::*)(Args...)>
+  {};
+
+  /// <summary>
+  /// The inputs and outputs of the AutoFilter on type F
+  /// </summary>
+  template<class F>
+  struct pipeline_filter:
+    pipeline_signature<decltype(&F::AutoFilter)>
+  {};
+
+  // Accumulates every type produced and consumed by a list of filters
+  template<class Produced, class Consumed, class... Fs>
+  struct pipeline_dataflow {
+    typedef Produced produced;
+    typedef Consumed consumed;
+  };
+
+  template<class Produced, class Consumed, class F, class... Fs>
+  struct pipeline_dataflow<Produced, Consumed, F, Fs...>:
+    pipeline_dataflow<
+      typename pipeline_union<Produced, typename pipeline_filter<F>::outputs>::type,
+      typename pipeline_union<Consumed, typename pipeline_filter<F>::inputs>::type,
+      Fs...
+    >
+  {
+    static_assert(
+      std::is_same<
+        typename pipeline_difference<typename pipeline_filter<F>::outputs, Produced>::type,
+        typename pipeline_filter<F>::outputs
+      >::value,
+      "Each decoration in a static pipeline may be produced by only one filter"
+    );
+  };
+
+  /// <summary>
+  /// Orders filters so that every filter follows the producers of all of its inputs
+  /// </summary>
+  /// <remarks>
+  /// Each step selects the first pending filter, in declaration order, whose inputs are all available.
+  /// Skipped filters are reconsidered after each selection.
+  /// </remarks>
+  template<class Available, class Scheduled, class Skipped, class Pending>
+  struct pipeline_schedule;
+
+  // Every filter has been scheduled
+  template<class Available, class Scheduled>
+  struct pipeline_schedule<Available, Scheduled, pipeline_list<>, pipeline_list<>> {
+    typedef Scheduled type;
+  };
+
+  // No remaining filter can be scheduled
+  template<class Available, class Scheduled, class S, class... Skipped>
+  struct pipeline_schedule<Available, Scheduled, pipeline_list<S, Skipped...>, pipeline_list<>> {
+    static_assert(
+      pipeline_always_false<S>::value,
+      "The filters of a static pipeline form a cycle"
+    );
+    typedef Scheduled type;
+  };
+
+  template<class Available, class... Scheduled, class... Skipped, class F, class... Pending>
+  struct pipeline_schedule<Available, pipeline_list<Scheduled...>, pipeline_list<Skipped...>, pipeline_list<F, Pending...>>:
+    std::conditional<
+      pipeline_includes<Available, typename pipeline_filter<F>::inputs>::value,
+      pipeline_schedule<
+        typename pipeline_union<Available, typename pipeline_filter<F>::outputs>::type,
+        pipeline_list<Scheduled..., F>,
+        pipeline_list<>,
+        pipeline_list<Skipped..., Pending...>
+      >,
+      pipeline_schedule<
+        Available,
+        pipeline_list<Scheduled...>,
+        pipeline_list<Skipped..., F>,
+        pipeline_list<Pending...>
+      >
+    >::type
+  {};
+
+  template<class Filters, class Sources, class Exported, class Internal, class Schedule, class Index>
+  class static_pipeline;
+
+  /// <summary>
+  /// The computed dataflow of the specified filters
+  /// </summary>
+  template<class... Filters>
+  struct static_pipeline_of {
+    typedef pipeline_dataflow<pipeline_list<>, pipeline_list<>, Filters...> dataflow;
+
+    // Inputs which no filter in the pipeline produces, these must be supplied externally
+    typedef typename pipeline_difference<typename dataflow::consumed, typename dataflow::produced>::type sources;
+
+    // Outputs which no filter in the pipeline consumes
+    typedef typename pipeline_difference<typename dataflow::produced, typename dataflow::consumed>::type exported;
+
+    // Outputs which are consumed within the pipeline
+    typedef typename pipeline_difference<typename dataflow::produced, exported>::type internal;
+
+    typedef typename pipeline_schedule<sources, pipeline_list<>, pipeline_list<>, pipeline_list<Filters...>>::type schedule;
+
+    typedef static_pipeline<
+      pipeline_list<Filters...>,
+      sources,
+      exported,
+      internal,
+      schedule,
+      typename make_index_tuple<internal::N>::type
+    > type;
+  };
+
+  template<class... Filters, class... Sources, class... Exported, class... Internal, class... Schedule, int... I>
+  class static_pipeline<
+    pipeline_list<Filters...>,
+    pipeline_list<Sources...>,
+    pipeline_list<Exported...>,
+    pipeline_list<Internal...>,
+    pipeline_list<Schedule...>,
+    index_tuple<I...>
+  > {
+  public:
+    typedef pipeline_list<Sources...> sources;
+    typedef pipeline_list<Exported...> exported;
+    typedef pipeline_list<Internal...> internal;
+    typedef pipeline_list<Schedule...> schedule;
+
+  private:
+    // Every decoration handled by this pipeline, in the order in which they appear in the store
+    typedef pipeline_list<Sources..., Exported..., Internal...> t_decorations;
+
+    // Pointers to each decoration, the store is constructed on the stack for each call
+    typedef std::tuple<const Sources*..., Exported*..., Internal*...> t_store;
+
+    std::tuple<Filters...> m_filters;
+
+    template<class F>
+    void Call(t_store& store) {
+      pipeline_filter<F>::template Call<t_decorations>(GetFilter<F>(), store);
+    }
+
+  public:
+    /// <returns>The instance of the specified filter owned by this pipeline</returns>
+    template<class F>
+    F& GetFilter(void) {
+      return std::get<pipeline_index<pipeline_list<Filters...>, F>::value>(m_filters);
+    }
+
+    /// <summary>
+    /// Calls each filter in this pipeline in dependency order
+    /// </summary>
+    /// <remarks>
+    /// Intermediate decorations, those both produced and consumed within the pipeline, are held in a
+    /// tuple on the stack for the duration of the call.  When the pipeline is added to a context with
+    /// an AutoPacketFactory, this method is an ordinary AutoFilter: the pipeline runs once all of its
+    /// sources are present on a packet, and its exported outputs are attached to that packet where any
+    /// dynamic filter may consume them.
+    /// </remarks>
+    void AutoFilter(const Sources&... sources, Exported&... exported) {
+      std::tuple<Internal...> intermediate;
+      t_store store(&sources..., &exported..., &std::get<I>(intermediate)...);
+
+      // Braced initialization guarantees that calls are made in order
+      int order[] = {0, (Call<Schedule>(store), 0)...};
+      (void)order;
+    }
+  };
+}
+}
+
+/// <summary>
+/// A pipeline of AutoFilters whose dataflow is resolved at compile time
+/// </summary>
+/// <remarks>
+/// The filters are held by value and called directly, in an order worked out at compile time from
+/// their argument types, without any of the type erasure or satisfaction counting that an
+/// AutoPacketFactory performs.  Filter types may be listed in any order.  Their AutoFilter methods must
+/// return void and must take inputs by value or by const reference and outputs by reference.  A
+/// decoration may be produced by at most one of the filters, and the filters may not form a cycle.
+///
+/// Inputs which no filter in the list produces become the sources of the pipeline, and outputs which
+/// no filter in the list consumes are exported.  The pipeline is itself an AutoFilter taking its
+/// sources by const reference and its exported outputs by reference, in the order in which they are
+/// first mentioned.  It may therefore be added to any context with AutoRequired, where it coexists with
+/// dynamically registered filters, or called directly without a packet.
+/// </remarks>
+template<class... Filters>
+using StaticPipeline = typename autowiring::detail::static_pipeline_of<Filters...>::type;
@@ -0,0 +1,130 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "TypeRelations.h"
+#include <algorithm>
+#include MUTEX_HEADER
+#include TYPE_INDEX_HEADER
+#include STL_UNORDERED_MAP
+#include STL_UNORDERED_SET
+
+using namespace autowiring;
+
+TypeRelations::TypeRelations(void) {
+  for (auto& block : m_blocks)
+    block.store(nullptr, std::memory_order_relaxed);
+}
+
+TypeRelations::~TypeRelations(void) {
+  for (auto& block : m_blocks)
+    delete block.load(std::memory_order_relaxed);
+}
+
+TypeRelations& TypeRelations::For(const std::type_info& ti) {
+  // Relations are deliberately never freed, contexts may still be adding members during static destruction
+  static std::mutex& lock = *new std::mutex;
+  static auto& relations = *new std::unordered_map<std::type_index, std::unique_ptr<TypeRelations>>;
+
+  std::lock_guard<std::mutex> lk(lock);
+  auto& retVal = relations[ti];
+  if (!retVal)
+    retVal.reset(new TypeRelations);
+  return *retVal;
+}
+
+namespace {
+  // Every interface that has been searched for in any context, in order of registration
+  struct InterfaceRegistry {
+    std::mutex lock;
+    std::vector<auto_id> interfaces;
+    std::unordered_set<const auto_id_block*> known;
+    std::atomic<size_t> count{0};
+  };
+
+  InterfaceRegistry& GetRegistry(void) {
+    // Never freed for the same reason relations are not
+    static auto& registry = *new InterfaceRegistry;
+    return registry;
+  }
+}
+
+std::atomic<uint8_t>* TypeRelations::Slot(auto_id type) {
+  size_t index = std::hash<auto_id>()(type);
+  if (!index || index >= BlockSize * BlockCount)
+    return nullptr;
+
+  auto& slot = m_blocks[index / BlockSize];
+  Block* block = slot.load(std::memory_order_acquire);
+  if (!block) {
+    // Another thread may be allocating the same block, only one allocation may be kept
+    Block* created = new Block;
+    for (auto& e : created->entries)
+      e.store(Unknown, std::memory_order_relaxed);
+    if (slot.compare_exchange_strong(block, created, std::memory_order_acq_rel))
+      block = created;
+    else
+      delete created;
+  }
+  return &block->entries[index % BlockSize];
+}
+
+std::shared_ptr<void> TypeRelations::Cast(const std::shared_ptr<CoreObject>& obj, auto_id type) {
+  // A type without a caster may not have been fully initialized yet, so nothing is recorded for it
+  if (!obj || !type.block->pFromObj || type.block->pFromObj == &auto_id_block::NullFromObj)
+    return nullptr;
+
+  auto* slot = Slot(type);
+  if (slot && slot->load(std::memory_order_relaxed) == Unrelated)
+    return nullptr;
+
+  // Either the cast is known to succeed, or it has not been attempted yet
+  auto retVal = type.block->pFromObj(obj);
+  if (slot)
+    slot->store(retVal ? Implements : Unrelated, std::memory_order_relaxed);
+  return retVal;
+}
+
+bool TypeRelations::Register(auto_id type) {
+  if (!type.block->pFromObj || type.block->pFromObj == &auto_id_block::NullFromObj)
+    return false;
+
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lk(registry.lock);
+  if (registry.known.insert(type.block).second) {
+    registry.interfaces.push_back(type);
+    registry.count.store(registry.interfaces.size(), std::memory_order_release);
+  }
+  return true;
+}
+
+size_t TypeRelations::GetRegisteredCount(void) {
+  return GetRegistry().count.load(std::memory_order_acquire);
+}
+
+void TypeRelations::Implemented(const std::shared_ptr<CoreObject>& obj, size_t begin, size_t end, std::vector<auto_id>& out) {
+  if (!obj)
+    return;
+
+  std::lock_guard<std::mutex> lk(m_lock);
+  if (m_nClassified < end) {
+    // Classify this class against the interfaces registered since it was last asked
+    std::vector<auto_id> pending;
+    {
+      auto& registry = GetRegistry();
+      std::lock_guard<std::mutex> rlk(registry.lock);
+      pending.assign(registry.interfaces.begin() + m_nClassified, registry.interfaces.begin() + end);
+    }
+    for (size_t i = 0; i < pending.size(); i++)
+      if (Cast(obj, pending[i]))
+        m_implements.emplace_back(m_nClassified + i, pending[i]);
+    m_nClassified = end;
+  }
+
+  auto q = std::lower_bound(
+    m_implements.begin(),
+    m_implements.end(),
+    begin,
+    [] (const std::pair<size_t, auto_id>& entry, size_t position) { return entry.first < position; }
+  );
+  for (; q != m_implements.end() && q->first < end; ++q)
+    out.push_back(q->second);
+}
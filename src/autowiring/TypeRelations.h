@@ -0,0 +1,96 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "auto_id.h"
+#include <atomic>
+#include <cstdint>
+#include <typeinfo>
+#include MEMORY_HEADER
+#include MUTEX_HEADER
+#include <vector>
+
+class CoreObject;
+
+namespace autowiring {
+
+/// \internal
+/// <summary>
+/// The interfaces that a single concrete class is known to implement, or known not to implement
+/// </summary>
+/// <remarks>
+/// There is one instance of this type for each concrete class that has been added to any context, and
+/// it is shared by all contexts in the process.  Whether a class implements an interface is a property
+/// of the two types alone, so the dynamic cast that decides it needs to be attempted only once per pair
+/// no matter how many contexts or objects are involved.  Results are indexed by the index of the
+/// interface's auto_id and may be read and recorded concurrently from any thread.
+///
+/// Every interface that some context has searched for is also entered into a process-wide registry,
+/// and each class records which registered interfaces it implements.  This lets a context find the
+/// members that implement an interface, and the searches that a new member satisfies, without testing
+/// every member against every search.  A class is classified against each registered interface at
+/// most once, the first time the class is asked for its interfaces after that interface is registered.
+/// </remarks>
+class TypeRelations {
+public:
+  TypeRelations(void);
+  TypeRelations(const TypeRelations&) = delete;
+  ~TypeRelations(void);
+
+  static const size_t BlockSize = 256;
+  static const size_t BlockCount = 64;
+
+  /// <returns>The relations of the specified concrete class, created if necessary</returns>
+  static TypeRelations& For(const std::type_info& ti);
+
+private:
+  enum Relation : uint8_t {
+    Unknown = 0,
+    Unrelated,
+    Implements
+  };
+
+  struct Block {
+    std::atomic<uint8_t> entries[BlockSize];
+  };
+  std::atomic<Block*> m_blocks[BlockCount];
+
+  // Registered interfaces this class implements, by order of registration, and the number of
+  // registered interfaces against which this class has been classified
+  std::mutex m_lock;
+  std::vector<std::pair<size_t, auto_id>> m_implements;
+  size_t m_nClassified = 0;
+
+  // The slot for the specified interface, or nullptr if the index of the interface lies beyond the table
+  std::atomic<uint8_t>* Slot(auto_id type);
+
+public:
+  /// <summary>
+  /// Casts an instance of this class to the specified interface
+  /// </summary>
+  /// <param name="obj">An object whose concrete class is the one described by this instance</param>
+  /// <param name="type">The interface to be obtained</param>
+  /// <returns>The requested interface, or nullptr if the class does not implement it</returns>
+  std::shared_ptr<void> Cast(const std::shared_ptr<CoreObject>& obj, auto_id type);
+
+  /// <summary>
+  /// Enters the specified interface into the registry of interfaces that classes are classified against
+  /// </summary>
+  /// <returns>False if the interface has no caster, and so cannot be registered yet</returns>
+  /// <remarks>
+  /// Registering an interface more than once has no effect
+  /// </remarks>
+  static bool Register(auto_id type);
+
+  /// <returns>The number of registered interfaces</returns>
+  static size_t GetRegisteredCount(void);
+
+  /// <summary>
+  /// Finds the registered interfaces implemented by this class
+  /// </summary>
+  /// <param name="obj">An object whose concrete class is the one described by this instance</param>
+  /// <param name="begin">The position, in order of registration, of the first interface to consider</param>
+  /// <param name="end">One past the position of the last interface to consider</param>
+  /// <param name="out">Receives each interface in the range which this class implements</param>
+  void Implemented(const std::shared_ptr<CoreObject>& obj, size_t begin, size_t end, std::vector<auto_id>& out);
+};
+
+}
@@ -1,5 +1,6 @@
 // Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
 #pragma once
+#include TYPE_TRAITS_HEADER
 
 namespace autowiring {
 
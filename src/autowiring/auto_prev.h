@@ -16,6 +16,8 @@ class auto_arg;
 /// </remarks>
 template<class T, int N = 1>
 struct auto_prev {
+  static_assert(0 < N && N < 64, "auto_prev may only refer to between 1 and 63 prior packets");
+
 public:
   auto_prev(const T* value) :
     value(value)
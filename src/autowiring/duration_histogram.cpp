@@ -0,0 +1,118 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "duration_histogram.h"
+
+using namespace autowiring;
+
+const size_t duration_histogram::SubBuckets;
+const size_t duration_histogram::BucketCount;
+
+duration_histogram::duration_histogram(void) :
+  m_count(0),
+  m_sum(0),
+  m_max(0)
+{
+  for (auto& count : m_counts)
+    count.store(0, std::memory_order_relaxed);
+}
+
+duration_histogram::snapshot::snapshot(void) :
+  counts(),
+  count(0),
+  sum(0),
+  max(0)
+{}
+
+size_t duration_histogram::bucket_of(uint64_t value) {
+  // Small values are recorded exactly:
+  if (value < 2 * SubBuckets)
+    return static_cast<size_t>(value);
+
+  // Position of the most significant bit, found by binary search
+  size_t msb = 0;
+  for (size_t shift = 32; shift; shift /= 2)
+    if (value >> (msb + shift))
+      msb += shift;
+
+  // The three bits following the most significant bit select the sub-bucket
+  return 2 * SubBuckets + (msb - 4) * SubBuckets + static_cast<size_t>((value >> (msb - 3)) & (SubBuckets - 1));
+}
+
+uint64_t duration_histogram::bucket_floor(size_t bucket) {
+  if (bucket < 2 * SubBuckets)
+    return bucket;
+
+  size_t msb = (bucket - 2 * SubBuckets) / SubBuckets + 4;
+  uint64_t sub = (bucket - 2 * SubBuckets) % SubBuckets;
+  return (SubBuckets + sub) << (msb - 3);
+}
+
+void duration_histogram::record(std::chrono::nanoseconds duration) {
+  uint64_t value = duration.count() < 0 ? 0 : static_cast<uint64_t>(duration.count());
+
+  // The count is incremented before the bucket, and released by it, so that a concurrent reset, which
+  // subtracts the bucket totals it takes from the count, never subtracts a sample the count lacks
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_counts[bucket_of(value)].fetch_add(1, std::memory_order_release);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+
+  // Maximum is updated by compare-exchange, only contended if this is a new maximum
+  for (
+    uint64_t prior = m_max.load(std::memory_order_relaxed);
+    prior < value && !m_max.compare_exchange_weak(prior, value, std::memory_order_relaxed);
+  );
+}
+
+duration_histogram::snapshot duration_histogram::take(bool reset) {
+  snapshot retVal;
+  for (size_t i = 0; i < BucketCount; i++) {
+    retVal.counts[i] =
+      reset ?
+      m_counts[i].exchange(0, std::memory_order_acquire) :
+      m_counts[i].load(std::memory_order_relaxed);
+    retVal.count += retVal.counts[i];
+  }
+
+  // The count is derived from the buckets so that percentiles are self-consistent, the atomic count
+  // is only maintained for cheap reads
+  if (reset) {
+    m_count.fetch_sub(retVal.count, std::memory_order_relaxed);
+    retVal.sum = m_sum.exchange(0, std::memory_order_relaxed);
+    retVal.max = m_max.exchange(0, std::memory_order_relaxed);
+  }
+  else {
+    retVal.sum = m_sum.load(std::memory_order_relaxed);
+    retVal.max = m_max.load(std::memory_order_relaxed);
+  }
+  return retVal;
+}
+
+std::chrono::nanoseconds duration_histogram::snapshot::percentile(double fraction) const {
+  if (!count)
+    return std::chrono::nanoseconds(0);
+
+  // Rank of the requested sample, one-based
+  uint64_t rank = static_cast<uint64_t>(fraction * count + 0.5);
+  if (rank < 1)
+    rank = 1;
+  if (rank > count)
+    rank = count;
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BucketCount; i++) {
+    seen += counts[i];
+    if (seen < rank)
+      continue;
+
+    // Report the midpoint of the bucket, but never more than the largest sample seen
+    uint64_t lo = bucket_floor(i);
+    uint64_t hi = i + 1 < BucketCount ? bucket_floor(i + 1) : lo;
+    uint64_t value = lo + (hi - lo) / 2;
+    return std::chrono::nanoseconds(max && value > max ? max : value);
+  }
+  return std::chrono::nanoseconds(max);
+}
+
+std::chrono::nanoseconds duration_histogram::snapshot::mean(void) const {
+  return std::chrono::nanoseconds(count ? sum / count : 0);
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include <atomic>
+#include CHRONO_HEADER
+#include <cstddef>
+#include <cstdint>
+
+namespace autowiring {
+
+/// <summary>
+/// A lock-free, log-linear histogram of nanosecond durations
+/// </summary>
+/// <remarks>
+/// Each power of two is divided into eight buckets, so any recorded value can be recovered to within
+/// about 12% of its true value.  Recording a sample is a handful of relaxed atomic operations and never
+/// blocks.  Snapshots are taken bucket-by-bucket, so a snapshot taken while samples are being recorded
+/// may include some of those samples but not others; each sample is counted exactly once, either by a
+/// snapshot which resets the histogram or by the next one.
+/// </remarks>
+class duration_histogram {
+public:
+  duration_histogram(void);
+  duration_histogram(const duration_histogram&) = delete;
+
+  // Buckets per power of two, and the total number of buckets required to cover 64-bit values
+  static const size_t SubBuckets = 8;
+  static const size_t BucketCount = 2 * SubBuckets + (64 - 4) * SubBuckets;
+
+  /// <summary>
+  /// A point-in-time copy of the histogram
+  /// </summary>
+  struct snapshot {
+    snapshot(void);
+
+    uint64_t counts[BucketCount];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    /// <returns>The approximate value below which the specified fraction of samples fall</returns>
+    /// <param name="fraction">A value between 0 and 1, for instance 0.99 for the 99th percentile</param>
+    std::chrono::nanoseconds percentile(double fraction) const;
+
+    /// <returns>The arithmetic mean of all samples, or zero if there are no samples</returns>
+    std::chrono::nanoseconds mean(void) const;
+  };
+
+private:
+  std::atomic<uint64_t> m_counts[BucketCount];
+  std::atomic<uint64_t> m_count;
+  std::atomic<uint64_t> m_sum;
+  std::atomic<uint64_t> m_max;
+
+public:
+  /// <returns>The index of the bucket holding the specified value</returns>
+  static size_t bucket_of(uint64_t value);
+
+  /// <returns>The smallest value held by the specified bucket</returns>
+  static uint64_t bucket_floor(size_t bucket);
+
+  /// <summary>
+  /// Records a single sample
+  /// </summary>
+  void record(std::chrono::nanoseconds duration);
+
+  /// <returns>The number of samples recorded since the last reset</returns>
+  uint64_t count(void) const { return m_count.load(std::memory_order_relaxed); }
+
+  /// <returns>The largest sample recorded since the last reset</returns>
+  std::chrono::nanoseconds max(void) const { return std::chrono::nanoseconds(m_max.load(std::memory_order_relaxed)); }
+
+  /// <summary>
+  /// Copies the current state of the histogram, optionally resetting it at the same time
+  /// </summary>
+  snapshot take(bool reset = false);
+
+  /// <summary>
+  /// Discards all recorded samples
+  /// </summary>
+  void reset(void) { take(true); }
+};
+
+}
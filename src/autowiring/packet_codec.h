@@ -0,0 +1,78 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include "autowiring_error.h"
+#include "marshaller.h"
+#include <cstdint>
+#include <string>
+#include <string.h>
+#include TYPE_TRAITS_HEADER
+
+namespace autowiring {
+  /// <summary>
+  /// Codec which records a value as its object representation
+  /// </summary>
+  /// <remarks>
+  /// Only suitable for types whose bytes mean the same thing when replayed in another process.  A
+  /// trivially copyable type that holds a pointer, a handle, or anything else that refers to state
+  /// outside of the value itself must not use this codec.  Types for which raw recording is safe may
+  /// opt in by deriving a packet_codec specialization from this one:
+  ///
+  ///   namespace autowiring {
+  ///     template<> struct packet_codec<MyType> : raw_packet_codec<MyType> {};
+  ///   }
+  /// </remarks>
+  template<typename T>
+  struct raw_packet_codec {
+    static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types may be recorded as raw bytes");
+
+    static void encode(const T& value, std::string& buf) {
+      buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static void decode(const uint8_t* data, size_t len, T& value) {
+      if (len != sizeof(T))
+        throw autowiring_error("Recorded decoration size does not match the size of its type");
+      memcpy(&value, data, sizeof(T));
+    }
+  };
+
+  /// <summary>
+  /// Binary codec used to record and replay decorations of type T
+  /// </summary>
+  /// <remarks>
+  /// Arithmetic and enumeration types are stored as their object representation, and all other types
+  /// are stored in the string form produced by their marshaller.  Other trivially copyable types are
+  /// not recorded as raw bytes by default, because nothing prevents them from holding pointers.
+  /// Specialize this template to provide a more compact or more portable encoding for a particular
+  /// type, or derive the specialization from raw_packet_codec.
+  /// </remarks>
+  template<typename T, typename = void>
+  struct packet_codec {
+    static_assert(
+      !std::is_base_of<invalid_marshal_base, marshaller<T>>::value,
+      "Type T has neither a marshaller nor a packet_codec specialization.  If T holds no pointers, "
+      "specialize packet_codec<T> from raw_packet_codec<T>."
+    );
+
+    /// <summary>
+    /// Appends the encoded form of the specified value to the passed buffer
+    /// </summary>
+    static void encode(const T& value, std::string& buf) {
+      buf += marshaller<T>().marshal(&value);
+    }
+
+    /// <summary>
+    /// Reconstructs a value from the encoded bytes produced by encode
+    /// </summary>
+    static void decode(const uint8_t* data, size_t len, T& value) {
+      // Marshallers expect a null-terminated string
+      std::string str(reinterpret_cast<const char*>(data), len);
+      marshaller<T>().unmarshal(&value, str.c_str());
+    }
+  };
+
+  template<typename T>
+  struct packet_codec<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type> :
+    raw_packet_codec<T>
+  {};
+}
@@ -0,0 +1,30 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+#include TYPE_TRAITS_HEADER
+
+namespace autowiring {
+
+/// <summary>
+/// Determines whether the AutoFilter on type T may be skipped on packets which are past their deadline
+/// </summary>
+/// <remarks>
+/// A filter declares itself skippable with a static member:
+///
+///   static const bool skippable = true;
+///
+/// When a skippable filter would be called on a packet whose deadline has passed, the filter is not
+/// called and its outputs are marked unsatisfiable instead.  This is intended for expensive filters
+/// whose outputs are optional to the rest of the pipeline.
+/// </remarks>
+template<class T>
+struct skippable_of {
+  template<class U>
+  static std::integral_constant<bool, U::skippable> select(U*);
+
+  template<class U>
+  static std::false_type select(...);
+
+  static const bool value = decltype(select<T>(nullptr))::value;
+};
+
+}
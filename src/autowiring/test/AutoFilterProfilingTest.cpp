@@ -0,0 +1,107 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/demangle.h>
+#include <sstream>
+#include <thread>
+
+class AutoFilterProfilingTest:
+  public testing::Test
+{
+public:
+  AutoFilterProfilingTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+  AutoRequired<AutoPacketFactory> factory;
+};
+
+namespace {
+  class SlowFilter {
+  public:
+    void AutoFilter(int value, std::string& out) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      out = std::to_string(value);
+    }
+  };
+
+  class WaitsForFloat {
+  public:
+    void AutoFilter(const std::string&, float) {}
+  };
+}
+
+TEST_F(AutoFilterProfilingTest, DisabledByDefault) {
+  AutoRequired<SlowFilter> slow;
+  factory->NewPacket()->Decorate(1);
+
+  ASSERT_FALSE(factory->IsFilterProfilingEnabled());
+  ASSERT_TRUE(factory->GetFilterProfiles().empty()) << "Filters were profiled without profiling being enabled";
+}
+
+TEST_F(AutoFilterProfilingTest, CallsAndRunTimeRecorded) {
+  factory->EnableFilterProfiling();
+  AutoRequired<SlowFilter> slow;
+  AutoRequired<WaitsForFloat> waits;
+
+  for (int i = 0; i < 3; i++) {
+    auto packet = factory->NewPacket();
+    packet->Decorate(i);
+    packet->Decorate(1.0f);
+  }
+
+  auto profiles = factory->GetFilterProfiles();
+  ASSERT_EQ(2UL, profiles.size()) << "Expected one profile per filter";
+  for (const auto& profile : profiles) {
+    ASSERT_EQ(3ULL, profile.calls) << "Call count was incorrect for " << autowiring::demangle(profile.type);
+    if (profile.type == auto_id_t<SlowFilter>{})
+      ASSERT_LE(std::chrono::milliseconds(2).count(), (long long)profile.runTime.max) << "Run time of a slow filter was not recorded";
+  }
+}
+
+TEST_F(AutoFilterProfilingTest, WaitTimeRecorded) {
+  factory->EnableFilterProfiling();
+  AutoRequired<WaitsForFloat> waits;
+
+  auto packet = factory->NewPacket();
+  packet->Decorate(std::string("hello"));
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  packet->Decorate(1.0f);
+
+  auto profiles = factory->GetFilterProfiles(true);
+  ASSERT_EQ(1UL, profiles.size());
+  ASSERT_LE(std::chrono::milliseconds(5).count(), (long long)profiles[0].waitTime.max) << "Time spent waiting for inputs was not recorded";
+
+  profiles = factory->GetFilterProfiles();
+  ASSERT_EQ(0ULL, profiles[0].calls) << "Profile was not reset";
+}
+
+TEST_F(AutoFilterProfilingTest, ExportWritesEachFilter) {
+  factory->EnableFilterProfiling();
+  AutoRequired<SlowFilter> slow;
+  factory->NewPacket()->Decorate(1);
+
+  std::stringstream ss;
+  factory->WriteFilterProfiles(ss);
+
+  std::string header, line;
+  ASSERT_TRUE(!!std::getline(ss, header));
+  ASSERT_TRUE(!!std::getline(ss, line)) << "Profile for a called filter was not exported";
+  ASSERT_NE(std::string::npos, line.find("SlowFilter")) << "Exported profile did not name its filter";
+  ASSERT_FALSE(!!std::getline(ss, line)) << "Unexpected additional profiles were exported";
+}
+
+TEST_F(AutoFilterProfilingTest, ProfileDiscardedWithFilter) {
+  factory->EnableFilterProfiling();
+  auto desc = factory->AddSubscriber(std::make_shared<WaitsForFloat>());
+
+  // A packet issued before removal keeps recording into the discarded profile
+  auto packet = factory->NewPacket();
+  packet->Decorate(std::string("hello"));
+  ASSERT_EQ(1UL, factory->GetFilterProfiles().size());
+
+  factory->RemoveSubscriber(desc);
+  ASSERT_TRUE(factory->GetFilterProfiles().empty()) << "Profile of a removed filter was retained";
+
+  packet->Decorate(1.0f);
+  packet.reset();
+  ASSERT_TRUE(factory->GetFilterProfiles().empty()) << "Profile of a removed filter was recreated by an outstanding packet";
+}
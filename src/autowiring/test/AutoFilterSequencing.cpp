@@ -337,3 +337,36 @@ TEST_F(AutoFilterSequencing, UnsatisfiableImmediate) {
   ASSERT_EQ(0UL, twoInRunCt) << "A zero-argument immediate filter was incorrectly run";
   ASSERT_NO_THROW(packet->DecorateImmediate(Decoration<1>{}));
 }
+
+TEST_F(AutoFilterSequencing, SlidingWindowPrev) {
+  AutoRequired<AutoPacketFactory> factory;
+
+  std::vector<int> prev1;
+  std::vector<int> prev30;
+  *factory += [&prev1](int, auto_prev<int> prev) {
+    prev1.push_back(prev ? *prev : -1);
+  };
+  *factory += [&prev30](int, auto_prev<int, 30> prev) {
+    prev30.push_back(prev ? *prev : -1);
+  };
+
+  for (int i = 0; i < 100; i++)
+    factory->NewPacket()->Decorate(i);
+
+  ASSERT_EQ(100UL, prev1.size());
+  ASSERT_EQ(100UL, prev30.size());
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i < 1 ? -1 : i - 1, prev1[i]) << "auto_prev<int> had the wrong value on packet " << i;
+    ASSERT_EQ(i < 30 ? -1 : i - 30, prev30[i]) << "auto_prev<int, 30> had the wrong value on packet " << i;
+  }
+}
+
+TEST_F(AutoFilterSequencing, TimeshiftsAreSparse) {
+  AutoRequired<AutoPacketFactory> factory;
+  *factory += [](auto_prev<int, 30>) {};
+
+  auto packet = factory->NewPacket();
+
+  // Only the current decoration and the one consumed 30 packets later should be tracked
+  ASSERT_EQ(2UL, packet->GetDecorationTypeCount()) << "Intermediate timeshifts were materialized on the packet";
+}
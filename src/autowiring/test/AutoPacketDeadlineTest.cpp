@@ -0,0 +1,137 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/autowiring.h>
+#include <autowiring/skippable.h>
+#include "TestFixtures/Decoration.hpp"
+#include <future>
+#include <thread>
+
+class AutoPacketDeadlineTest:
+  public testing::Test
+{
+public:
+  AutoPacketDeadlineTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+
+  AutoRequired<AutoPacketFactory> factory;
+};
+
+namespace {
+  class ExpensiveFilter {
+  public:
+    static const bool skippable = true;
+
+    void AutoFilter(const Decoration<0>&, Decoration<1>& out) {
+      called++;
+      out.i = 1;
+    }
+
+    int called = 0;
+  };
+
+  class RequiredFilter {
+  public:
+    void AutoFilter(const Decoration<0>&, Decoration<2>& out) {
+      called++;
+    }
+
+    int called = 0;
+  };
+
+  class OptionalConsumer {
+  public:
+    void AutoFilter(std::shared_ptr<const Decoration<1>> in) {
+      called++;
+      received = !!in;
+    }
+
+    int called = 0;
+    bool received = false;
+  };
+
+  class DeferredExpensiveFilter:
+    public CoreThread
+  {
+  public:
+    static const bool skippable = true;
+
+    Deferred AutoFilter(const Decoration<0>&, Decoration<1>& out) {
+      called++;
+      return Deferred(this);
+    }
+
+    std::atomic<int> called{0};
+  };
+}
+
+static_assert(autowiring::skippable_of<ExpensiveFilter>::value, "Skippable filter was not detected");
+static_assert(!autowiring::skippable_of<RequiredFilter>::value, "Filter was incorrectly detected as skippable");
+
+TEST_F(AutoPacketDeadlineTest, NoDeadlineByDefault) {
+  AutoRequired<ExpensiveFilter> expensive;
+
+  auto packet = factory->NewPacket();
+  ASSERT_FALSE(packet->HasDeadline());
+  ASSERT_FALSE(packet->IsPastDeadline());
+
+  packet->Decorate(Decoration<0>());
+  ASSERT_EQ(1, expensive->called) << "Skippable filter was not called on a packet without a deadline";
+}
+
+TEST_F(AutoPacketDeadlineTest, SkippableFilterSkippedPastDeadline) {
+  AutoRequired<ExpensiveFilter> expensive;
+  AutoRequired<RequiredFilter> required;
+  AutoRequired<OptionalConsumer> consumer;
+
+  auto packet = factory->NewPacket(std::chrono::steady_clock::now() - std::chrono::milliseconds(1));
+  ASSERT_TRUE(packet->HasDeadline());
+  ASSERT_TRUE(packet->IsPastDeadline());
+  packet->Decorate(Decoration<0>());
+
+  ASSERT_EQ(0, expensive->called) << "Skippable filter was called on a packet past its deadline";
+  ASSERT_EQ(1, required->called) << "Filter which is not skippable was not called";
+  ASSERT_TRUE(packet->IsUnsatisfiable<Decoration<1>>()) << "Output of a skipped filter was not marked unsatisfiable";
+  ASSERT_EQ(1, consumer->called) << "Consumer of a skipped output was not notified";
+  ASSERT_FALSE(consumer->received);
+
+  auto skips = factory->GetSkippedFilterCounts();
+  ASSERT_EQ(1UL, skips.size()) << "Expected exactly one filter to have been skipped";
+  ASSERT_EQ(auto_id_t<ExpensiveFilter>{}, skips[0].type);
+  ASSERT_EQ(1ULL, skips[0].skips);
+}
+
+TEST_F(AutoPacketDeadlineTest, FutureDeadlineIsHonored) {
+  AutoRequired<ExpensiveFilter> expensive;
+
+  auto packet = factory->NewPacket(std::chrono::seconds(60));
+  ASSERT_TRUE(packet->HasDeadline());
+  packet->Decorate(Decoration<0>());
+  ASSERT_EQ(1, expensive->called) << "Skippable filter was skipped before its deadline";
+  ASSERT_TRUE(factory->GetSkippedFilterCounts().empty());
+}
+
+TEST_F(AutoPacketDeadlineTest, DeferredFilterChecksDeadlineBeforeRunning) {
+  AutoRequired<DeferredExpensiveFilter> deferred;
+  AutoRequired<OptionalConsumer> consumer;
+
+  // Hold up the filter's dispatch queue until the packet's deadline has passed
+  auto barrier = std::make_shared<std::promise<void>>();
+  auto released = barrier->get_future().share();
+  *deferred += [released] { released.wait(); };
+
+  auto packet = factory->NewPacket(std::chrono::milliseconds(10));
+  packet->Decorate(Decoration<0>());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  barrier->set_value();
+
+  auto done = std::make_shared<std::promise<void>>();
+  *deferred += [done] { done->set_value(); };
+  ASSERT_EQ(std::future_status::ready, done->get_future().wait_for(std::chrono::seconds(5)));
+
+  ASSERT_EQ(0, deferred->called) << "Deferred skippable filter ran after its packet's deadline passed";
+  ASSERT_TRUE(packet->IsUnsatisfiable<Decoration<1>>()) << "Output of a skipped deferred filter was not marked unsatisfiable";
+  ASSERT_EQ(1, consumer->called);
+  ASSERT_EQ(1UL, factory->GetSkippedFilterCounts().size());
+}
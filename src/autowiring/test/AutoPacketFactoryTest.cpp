@@ -1,5 +1,6 @@
 // Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
 #include "stdafx.h"
+#include "TestFixtures/Decoration.hpp"
 #include <autowiring/CoreThread.h>
 #include CHRONO_HEADER
 #include THREAD_HEADER
@@ -168,6 +169,26 @@ TEST_F(AutoPacketFactoryTest, AutoPacketStatistics) {
   ASSERT_LE(packetDelay, factory->GetMeanPacketLifetime()) << "The mean packet lifetime was less than the delay on each packet";
 }
 
+TEST_F(AutoPacketFactoryTest, AutoPacketStatisticsWindow) {
+  AutoCurrentContext ctxt;
+  AutoRequired<DelaysAutoPacketsOneMS> dapoms;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+
+  for (int i = 0; i < 10; ++i)
+    factory->NewPacket()->Decorate(i);
+
+  auto stats = factory->GetPacketStatistics(true);
+  ASSERT_EQ(10ULL, stats.lifetime.count) << "Not all packet lifetimes were recorded in the window";
+  ASSERT_LE(std::chrono::milliseconds(1), stats.lifetime.percentile(0.5)) << "Median packet lifetime was less than the delay on each packet";
+  ASSERT_LT(0.0, stats.rate()) << "Packet rate was not computed";
+  ASSERT_GE(1e3, stats.rate()) << "Packet rate exceeded what a 1ms delay allows";
+  ASSERT_EQ(0, factory->GetTotalPacketCount()) << "Statistics were not reset when the window was taken";
+
+  factory->NewPacket()->Decorate(99);
+  ASSERT_EQ(1, factory->GetTotalPacketCount()) << "Packets issued after a reset were not recorded";
+}
+
 TEST_F(AutoPacketFactoryTest, MultipleInstanceAddition) {
   AutoCurrentContext ctxt;
   AutoRequired<AutoPacketFactory> factory;
@@ -252,3 +273,235 @@ TEST_F(AutoPacketFactoryTest, IsRunningWhilePacketIssued) {
   ctxt->SignalShutdown();
   ASSERT_TRUE(factory->IsRunning()) << "Factory should be considered to be running as long as packets are outstanding";
 }
+
+TEST_F(AutoPacketFactoryTest, BlockingAdmission) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+  factory->SetAdmissionPolicy(autowiring::AdmissionPolicy::Block, 2);
+
+  auto first = factory->NewPacket();
+  auto second = factory->NewPacket();
+  ASSERT_EQ(nullptr, factory->TryNewPacket()) << "A packet was admitted while the factory was at capacity";
+  ASSERT_EQ(1ULL, factory->GetRejectedPacketCount());
+
+  std::atomic<bool> admitted{false};
+  std::thread t([&] {
+    factory->NewPacket();
+    admitted = true;
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_FALSE(admitted) << "NewPacket did not block while the factory was at capacity";
+
+  first.reset();
+  t.join();
+  ASSERT_TRUE(admitted);
+
+  // Predecessors hold their successors, so the packet issued on the thread is held by the second one
+  second.reset();
+  ASSERT_NE(nullptr, factory->TryNewPacket()) << "Capacity was not restored after packets were released";
+}
+
+TEST_F(AutoPacketFactoryTest, BlockedAdmissionEndsOnStop) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+  factory->SetAdmissionPolicy(autowiring::AdmissionPolicy::Block, 1);
+
+  auto held = factory->NewPacket();
+  std::atomic<bool> threw{false};
+  std::thread t([&] {
+    try {
+      factory->NewPacket();
+    }
+    catch (autowiring_error&) {
+      threw = true;
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ctxt->SignalShutdown();
+  t.join();
+  ASSERT_TRUE(threw) << "A blocked NewPacket call was not released when the factory stopped";
+}
+
+TEST_F(AutoPacketFactoryTest, DropOldestAdmission) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+  factory->SetAdmissionPolicy(autowiring::AdmissionPolicy::DropOldest, 2);
+
+  int nCalls = 0;
+  *factory += [&nCalls] (int) { nCalls++; };
+
+  auto first = factory->NewPacket();
+  auto second = factory->NewPacket();
+  auto third = factory->TryNewPacket();
+  ASSERT_NE(nullptr, third) << "No packet was admitted after the oldest packet was shed";
+  ASSERT_TRUE(first->IsShed()) << "Oldest packet was not shed when the factory was at capacity";
+  ASSERT_FALSE(second->IsShed());
+  ASSERT_FALSE(third->IsShed());
+  ASSERT_EQ(1ULL, factory->GetDroppedPacketCount());
+  ASSERT_EQ(0ULL, factory->GetRejectedPacketCount()) << "A packet admitted by shedding was counted as rejected";
+
+  first->Decorate(1);
+  ASSERT_EQ(0, nCalls) << "A filter was called on a shed packet";
+
+  // The shed packet no longer holds capacity, the next packet sheds the oldest live packet instead
+  auto fourth = factory->TryNewPacket();
+  ASSERT_NE(nullptr, fourth);
+  ASSERT_TRUE(second->IsShed()) << "Oldest live packet was not shed";
+  ASSERT_FALSE(third->IsShed());
+  ASSERT_EQ(2ULL, factory->GetDroppedPacketCount());
+
+  third->Decorate(3);
+  ASSERT_EQ(1, nCalls);
+}
+
+TEST_F(AutoPacketFactoryTest, DropOldestDoesNotWaitForShedPacket) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+  factory->SetAdmissionPolicy(autowiring::AdmissionPolicy::DropOldest, 1);
+
+  // The caller keeps the oldest packet alive throughout
+  auto held = factory->NewPacket();
+  std::atomic<bool> issued{false};
+  std::thread t([&] {
+    factory->NewPacket();
+    issued = true;
+  });
+
+  for (size_t i = 0; i < 200 && !issued; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  EXPECT_TRUE(issued) << "NewPacket waited for a shed packet that was still held";
+  EXPECT_TRUE(held->IsShed());
+
+  held.reset();
+  t.join();
+}
+
+TEST_F(AutoPacketFactoryTest, ShedPacketCascadesOutputs) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+  factory->SetAdmissionPolicy(autowiring::AdmissionPolicy::DropOldest, 1);
+
+  bool produced = false;
+  *factory += [&produced] (int, Decoration<0>&) { produced = true; };
+
+  auto packet = factory->NewPacket();
+  ASSERT_NE(nullptr, factory->TryNewPacket());
+  ASSERT_TRUE(packet->IsShed());
+
+  packet->Decorate(1);
+  ASSERT_FALSE(produced) << "A filter was called on a shed packet";
+  ASSERT_TRUE(packet->IsUnsatisfiable<Decoration<0>>()) << "Outputs of a filter not run on a shed packet were not marked unsatisfiable";
+}
+
+TEST_F(AutoPacketFactoryTest, UnsequencedIssue) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+  factory->EnableUnsequencedIssue();
+
+  std::atomic<int> nCalls{0};
+  *factory += [&nCalls] (int) { nCalls++; };
+
+  auto first = factory->NewPacket();
+  auto second = factory->NewPacket();
+  ASSERT_NE(second, first->Successor()) << "An unsequenced packet was issued as the successor of another";
+
+  // Many producers issue concurrently
+  std::vector<std::thread> producers;
+  for (int i = 0; i < 8; i++)
+    producers.emplace_back([factory] {
+      for (int j = 0; j < 500; j++)
+        factory->NewPacket()->Decorate(j);
+    });
+  for (auto& producer : producers)
+    producer.join();
+  ASSERT_EQ(8 * 500, nCalls) << "Filters were not called on every unsequenced packet";
+
+  first.reset();
+  second.reset();
+  ASSERT_EQ(0UL, factory->GetOutstandingPacketCount()) << "Unsequenced packets remained outstanding after release";
+}
+
+TEST_F(AutoPacketFactoryTest, UnsequencedFallsBackForTimeshift) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+  factory->EnableUnsequencedIssue();
+
+  int prior = 0;
+  *factory += [&prior] (int, auto_prev<int> prev) {
+    if (prev)
+      prior = *prev;
+  };
+
+  auto first = factory->NewPacket();
+  auto second = factory->NewPacket();
+  ASSERT_EQ(second, first->Successor()) << "Packets were not sequenced for a filter with a timeshifted input";
+
+  first->Decorate(101);
+  second->Decorate(102);
+  ASSERT_EQ(101, prior) << "Timeshifted input was not delivered in unsequenced mode";
+}
+
+TEST_F(AutoPacketFactoryTest, PacketsPinFilterGraph) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+
+  int nFirst = 0;
+  int nSecond = 0;
+  auto first = *factory += [&nFirst] (int) { nFirst++; };
+  auto before = factory->NewPacket();
+  uint64_t version = before->GetFilterGraphVersion();
+  ASSERT_NE(0ULL, version) << "Packet did not record the graph it was issued with";
+
+  auto second = *factory += [&nSecond] (int) { nSecond++; };
+  *factory -= first;
+  auto after = factory->NewPacket();
+  ASSERT_EQ(version, before->GetFilterGraphVersion()) << "Subscriber changes altered the graph of an issued packet";
+  ASSERT_EQ(version + 2, after->GetFilterGraphVersion()) << "Each subscriber change should publish a single new version";
+
+  before->Decorate(1);
+  after->Decorate(2);
+  ASSERT_EQ(1, nFirst) << "A removed filter was not called on a packet issued before its removal";
+  ASSERT_EQ(1, nSecond) << "An added filter was called on a packet issued before it was added";
+
+  // Redundant changes publish nothing
+  factory->AddSubscriber(second);
+  factory->RemoveSubscriber(first);
+  ASSERT_EQ(version + 2, factory->GetFilterGraph()->version);
+}
+
+TEST_F(AutoPacketFactoryTest, SubscriberChangesDuringIssue) {
+  AutoCurrentContext ctxt;
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+
+  std::atomic<bool> done{false};
+  std::thread mutator([&] {
+    while (!done) {
+      auto desc = *factory += [] (int, std::string&) {};
+      *factory -= desc;
+    }
+  });
+
+  // Odd versions are exactly those with the filter present, each packet must agree with its version.
+  // The mutator must be joined before anything is asserted.
+  size_t nMismatched = 0;
+  for (int i = 0; i < 2000; i++) {
+    auto packet = factory->NewPacket();
+    packet->Decorate(i);
+    if ((packet->GetFilterGraphVersion() % 2 == 1) != packet->Has<std::string>())
+      nMismatched++;
+  }
+  done = true;
+  mutator.join();
+  ASSERT_EQ(0UL, nMismatched) << "Packets did not run the filters of the graph they were issued with";
+}
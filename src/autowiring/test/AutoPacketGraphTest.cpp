@@ -0,0 +1,71 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/AutoPacketGraph.h>
+
+class AutoPacketGraphTest:
+  public testing::Test
+{
+public:
+  AutoPacketGraphTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+  AutoRequired<AutoPacketFactory> factory;
+};
+
+namespace {
+  class IntToString {
+  public:
+    void AutoFilter(int value, std::string& out) {
+      out = std::to_string(value);
+    }
+  };
+
+  size_t GetCount(const AutoPacketGraph::t_deliveryEdges& edges, auto_id type, DeliveryEdge::ArgType argType) {
+    for (auto& edge : edges)
+      if (edge.first.type_info == type && edge.first.arg_type == argType)
+        return edge.second;
+    return ~0UL;
+  }
+}
+
+TEST_F(AutoPacketGraphTest, DeliveriesAreCounted) {
+  AutoRequired<IntToString> filter;
+  AutoRequired<AutoPacketGraph> graph;
+
+  for (int i = 0; i < 4; i++)
+    factory->NewPacket()->Decorate(i);
+
+  // Packets that never received an input do not count as deliveries
+  factory->NewPacket();
+
+  auto edges = graph->GetDeliveryCounts();
+  ASSERT_EQ(2UL, edges.size()) << "Expected one input and one output edge";
+  ASSERT_EQ(4UL, GetCount(edges, auto_id_t<int>{}, DeliveryEdge::ArgType::Input));
+  ASSERT_EQ(4UL, GetCount(edges, auto_id_t<std::string>{}, DeliveryEdge::ArgType::Output));
+}
+
+TEST_F(AutoPacketGraphTest, SampledDeliveries) {
+  AutoRequired<IntToString> filter;
+  AutoRequired<AutoPacketGraph> graph;
+  graph->SetSampleRate(3);
+
+  for (int i = 0; i < 9; i++)
+    factory->NewPacket()->Decorate(i);
+
+  auto edges = graph->GetDeliveryCounts();
+  ASSERT_EQ(3UL, GetCount(edges, auto_id_t<int>{}, DeliveryEdge::ArgType::Input)) << "Unsampled packets were counted";
+}
+
+TEST_F(AutoPacketGraphTest, AdHocRecipientsIgnored) {
+  AutoRequired<AutoPacketGraph> graph;
+  AutoRequired<IntToString> filter;
+
+  bool called = false;
+  auto packet = factory->NewPacket();
+  packet->AddRecipient(AutoFilterDescriptor([&called] (const std::string&) { called = true; }));
+  packet->Decorate(1);
+  packet.reset();
+
+  ASSERT_TRUE(called);
+  ASSERT_EQ(1UL, GetCount(graph->GetDeliveryCounts(), auto_id_t<int>{}, DeliveryEdge::ArgType::Input));
+}
@@ -0,0 +1,178 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/AutoPacketRecorder.h>
+#include <cstdio>
+#include <fstream>
+#include THREAD_HEADER
+
+class AutoPacketRecorderTest:
+  public testing::Test
+{
+public:
+  AutoPacketRecorderTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+
+  ~AutoPacketRecorderTest(void) {
+    std::remove(path);
+  }
+
+  const char* const path = "AutoPacketRecorderTest.bin";
+  AutoRequired<AutoPacketFactory> factory;
+};
+
+namespace {
+  struct Sample {
+    int id;
+    float value;
+  };
+
+  class Doubler {
+  public:
+    void AutoFilter(const Sample& sample, double& out) {
+      out = sample.value * 2.0;
+    }
+  };
+
+  class Collector {
+  public:
+    void AutoFilter(const Sample& sample, const std::string& label, const double& doubled) {
+      samples.push_back(sample.id);
+      labels.push_back(label);
+      total += doubled;
+    }
+
+    std::vector<int> samples;
+    std::vector<std::string> labels;
+    double total = 0.0;
+  };
+}
+
+namespace autowiring {
+  // Sample holds no pointers, so its bytes mean the same thing on replay
+  template<>
+  struct packet_codec<Sample> :
+    raw_packet_codec<Sample>
+  {};
+}
+
+TEST_F(AutoPacketRecorderTest, RecordAndReplay) {
+  {
+    AutoRequired<AutoPacketRecorder> recorder;
+    AutoRequired<Doubler> doubler;
+    recorder->Record<Sample>();
+    recorder->Record<std::string>();
+    recorder->Open(path);
+
+    for (int i = 0; i < 5; i++) {
+      auto packet = factory->NewPacket();
+      packet->Decorate(Sample{i, i + 0.5f});
+      packet->Decorate(std::string("label") + std::to_string(i));
+    }
+    recorder->Close();
+    ASSERT_EQ(5ULL, recorder->GetRecordedPacketCount());
+  }
+
+  // Replay into a fresh pipeline that was not present during recording
+  AutoCreateContext ctxt;
+  CurrentContextPusher pshr(ctxt);
+  AutoRequired<AutoPacketFactory> replayFactory;
+  AutoRequired<Doubler> doubler;
+  AutoRequired<Collector> collector;
+  ctxt->Initiate();
+
+  AutoPacketReplayer replayer(path);
+  replayer.Replay<Sample>();
+  replayer.Replay<std::string>();
+  ASSERT_EQ(5UL, replayer.GetPacketCount());
+  ASSERT_EQ(5UL, replayer.Run(*replayFactory));
+
+  ASSERT_EQ((std::vector<int>{0, 1, 2, 3, 4}), collector->samples) << "Recorded decorations were not replayed in order";
+  ASSERT_EQ("label3", collector->labels[3]) << "A marshalled decoration was not reproduced";
+  ASSERT_DOUBLE_EQ(2.0 * (0.5 + 1.5 + 2.5 + 3.5 + 4.5), collector->total) << "Downstream filters did not process replayed packets";
+}
+
+TEST_F(AutoPacketRecorderTest, UnregisteredTypesAreNotReplayed) {
+  {
+    AutoRequired<AutoPacketRecorder> recorder;
+    recorder->Record<Sample>();
+    recorder->Record<std::string>();
+    recorder->Open(path);
+    auto packet = factory->NewPacket();
+    packet->Decorate(Sample{1, 1.0f});
+    packet->Decorate(std::string("ignored"));
+    packet.reset();
+    recorder->Close();
+  }
+
+  int nStrings = 0;
+  int nSamples = 0;
+  *factory += [&nStrings] (const std::string&) { nStrings++; };
+  *factory += [&nSamples] (const Sample&) { nSamples++; };
+
+  AutoPacketReplayer replayer(path);
+  replayer.Replay<Sample>();
+  replayer.Run(*factory);
+  ASSERT_EQ(1, nSamples);
+  ASSERT_EQ(0, nStrings) << "A decoration type that was not named for replay was attached";
+}
+
+TEST_F(AutoPacketRecorderTest, OriginalPacing) {
+  {
+    AutoRequired<AutoPacketRecorder> recorder;
+    recorder->Record<Sample>();
+    recorder->Open(path);
+    for (int i = 0; i < 3; i++) {
+      factory->NewPacket()->Decorate(Sample{i, 0.0f});
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    recorder->Close();
+  }
+
+  AutoPacketReplayer replayer(path);
+  replayer.Replay<Sample>();
+
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_EQ(3UL, replayer.Run(*factory, AutoPacketReplayer::Pacing::Original));
+  ASSERT_LE(std::chrono::milliseconds(20), std::chrono::steady_clock::now() - start) << "Replay did not preserve the original packet intervals";
+}
+
+TEST_F(AutoPacketRecorderTest, TruncatedRecording) {
+  {
+    AutoRequired<AutoPacketRecorder> recorder;
+    recorder->Record<Sample>();
+    recorder->Open(path);
+    for (int i = 0; i < 3; i++)
+      factory->NewPacket()->Decorate(Sample{i, 0.0f});
+    recorder->Close();
+  }
+
+  // Chop off part of the final packet, as though the recording process had been killed
+  std::string contents;
+  {
+    std::ifstream in(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  std::ofstream(path, std::ios::binary | std::ios::trunc).write(contents.data(), contents.size() - 3);
+
+  AutoPacketReplayer replayer(path);
+  ASSERT_EQ(2UL, replayer.GetPacketCount()) << "Replay should stop at the last complete packet";
+}
+
+TEST_F(AutoPacketRecorderTest, RejectsOtherFiles) {
+  std::ofstream(path) << "not a recording";
+  ASSERT_THROW(AutoPacketReplayer{path}, autowiring_error);
+  ASSERT_THROW(AutoPacketReplayer{"AutoPacketRecorderTest.missing"}, autowiring_error);
+}
+
+#ifdef __linux__
+TEST_F(AutoPacketRecorderTest, WriteFailureIsReported) {
+  AutoRequired<AutoPacketRecorder> recorder;
+  recorder->Record<Sample>();
+
+  // Every write to this device fails as though the disk were full
+  ASSERT_THROW(recorder->Open("/dev/full"), autowiring_error) << "A recording whose header could not be written was opened";
+  ASSERT_TRUE(recorder->IsFailed());
+  ASSERT_THROW(recorder->Close(), autowiring_error) << "Closing a failed recording did not report the failure";
+}
+#endif
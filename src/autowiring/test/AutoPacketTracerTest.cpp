@@ -0,0 +1,122 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/AutoPacketTracer.h>
+#include <sstream>
+
+typedef AutoPacketTraceEvent::Kind Kind;
+
+class AutoPacketTracerTest:
+  public testing::Test
+{
+public:
+  AutoPacketTracerTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+  AutoRequired<AutoPacketFactory> factory;
+};
+
+namespace {
+  class IntToString {
+  public:
+    void AutoFilter(int value, std::string& out) {
+      out = std::to_string(value);
+    }
+  };
+
+  class EveryThirdPacket:
+    public AutoPacketTracer
+  {
+  public:
+    EveryThirdPacket(void) : AutoPacketTracer(3) {}
+  };
+
+  size_t CountEvents(const std::vector<AutoPacketTraceEvent>& events, Kind kind) {
+    size_t n = 0;
+    for (auto& evt : events)
+      n += evt.kind == kind;
+    return n;
+  }
+}
+
+TEST_F(AutoPacketTracerTest, FilterCallsAreBracketed) {
+  AutoRequired<AutoPacketTracer> tracer;
+  AutoRequired<IntToString> filter;
+
+  factory->NewPacket()->Decorate(42);
+
+  auto events = tracer->GetEvents();
+  ASSERT_EQ(1ULL, tracer->GetTracedPacketCount());
+  ASSERT_EQ(1UL, CountEvents(events, Kind::PacketBegin));
+  ASSERT_EQ(1UL, CountEvents(events, Kind::PacketEnd)) << "Packet destruction was not traced";
+  ASSERT_EQ(2UL, CountEvents(events, Kind::Decorate)) << "Expected the input and output decorations to be traced";
+
+  // The filter must have started after its input arrived, and finished after its output was attached
+  auto find = [&events] (Kind kind, auto_id type) -> size_t {
+    for (size_t i = 0; i < events.size(); i++)
+      if (events[i].kind == kind && events[i].type == type)
+        return i;
+    return events.size();
+  };
+  size_t input = find(Kind::Decorate, auto_id_t<int>{});
+  size_t begin = find(Kind::FilterBegin, auto_id_t<IntToString>{});
+  size_t output = find(Kind::Decorate, auto_id_t<std::string>{});
+  size_t end = find(Kind::FilterEnd, auto_id_t<IntToString>{});
+  ASSERT_LT(end, events.size()) << "Filter call was not traced";
+  ASSERT_LT(input, begin);
+  ASSERT_LT(begin, output);
+  ASSERT_LE(output, end);
+}
+
+TEST_F(AutoPacketTracerTest, UnsatisfiableIsTraced) {
+  AutoRequired<AutoPacketTracer> tracer;
+  AutoRequired<IntToString> filter;
+
+  factory->NewPacket()->MarkUnsatisfiable<int>();
+
+  auto events = tracer->GetEvents();
+  ASSERT_LE(1UL, CountEvents(events, Kind::Unsatisfiable)) << "Unsatisfiable marking was not traced";
+  ASSERT_EQ(0UL, CountEvents(events, Kind::FilterBegin)) << "A filter was traced that should not have been called";
+}
+
+TEST_F(AutoPacketTracerTest, OnlySampledPacketsAreTraced) {
+  AutoRequired<EveryThirdPacket> tracer;
+  AutoRequired<IntToString> filter;
+
+  for (int i = 0; i < 9; i++)
+    factory->NewPacket()->Decorate(i);
+
+  auto events = tracer->GetEvents();
+  ASSERT_EQ(3ULL, tracer->GetTracedPacketCount());
+  ASSERT_EQ(3UL, CountEvents(events, Kind::FilterBegin)) << "Unsampled packets were traced";
+}
+
+TEST_F(AutoPacketTracerTest, RingOverwritesOldest) {
+  AutoRequired<AutoPacketTracer> tracer;
+  for (uint64_t i = 0; i < 10000; i++)
+    tracer->Record(Kind::Successor, i);
+
+  auto events = tracer->GetEvents();
+  ASSERT_EQ(4096UL, events.size()) << "Ring buffer did not retain exactly its capacity";
+  ASSERT_EQ(10000ULL - 4096ULL, events.front().packet) << "Oldest events were not the ones overwritten";
+  ASSERT_EQ(9999ULL, events.back().packet);
+}
+
+TEST_F(AutoPacketTracerTest, ChromeTraceFormat) {
+  AutoRequired<AutoPacketTracer> tracer;
+  AutoRequired<IntToString> filter;
+  factory->NewPacket()->Decorate(1);
+
+  std::stringstream ss;
+  tracer->WriteTrace(ss);
+
+  std::string trace = ss.str();
+  ASSERT_EQ(0UL, trace.find("{\"traceEvents\":[")) << "Trace did not begin with an event array";
+  ASSERT_NE(std::string::npos, trace.rfind("]}")) << "Trace event array was not terminated";
+
+  // Exactly one filter was called, it must appear as a single duration event
+  size_t begin = trace.find("\"ph\":\"B\"");
+  ASSERT_NE(std::string::npos, begin) << "Filter duration event was not written";
+  ASSERT_EQ(std::string::npos, trace.find("\"ph\":\"B\"", begin + 1)) << "Expected a single filter duration event";
+  ASSERT_NE(std::string::npos, trace.find("IntToString")) << "Filter was not named in the trace";
+  ASSERT_NE(std::string::npos, trace.find("\"ph\":\"E\""));
+}
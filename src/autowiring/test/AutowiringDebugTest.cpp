@@ -195,3 +195,96 @@ TEST_F(AutowiringDebugTest, PrintRunnables) {
     str
   );
 }
+
+class ProfiledInner {};
+
+class ProfiledOuter {
+public:
+  AutoRequired<ProfiledInner> inner;
+};
+
+class ProfiledRunnable:
+  public CoreObject,
+  public CoreRunnable
+{
+public:
+  bool OnStart(void) override { return true; }
+};
+
+TEST_F(AutowiringDebugTest, StartupProfiler) {
+  AutoCurrentContext()->Initiate();
+  AutoCreateContext ctxt;
+  auto profiler = autowiring::dbg::ProfileStartup(*ctxt);
+
+  auto child = ctxt->Create<void>();
+  ASSERT_EQ(profiler, child->GetProfiler()) << "Child context did not inherit its parent's profiler";
+
+  ctxt->Inject<ProfiledOuter>();
+  ctxt->Inject<ProfiledRunnable>();
+  ctxt->Initiate();
+
+  auto report = profiler->GetReport();
+  auto find = [&report] (autowiring::StartupPhase phase, const char* type) -> const autowiring::dbg::StartupProfileEntry* {
+    for (const auto& entry : report)
+      if (entry.phase == phase && entry.type.find(type) != std::string::npos)
+        return &entry;
+    return nullptr;
+  };
+
+  const auto* outer = find(autowiring::StartupPhase::Construct, "ProfiledOuter");
+  const auto* inner = find(autowiring::StartupPhase::Construct, "ProfiledInner");
+  ASSERT_NE(nullptr, outer) << "Construction of an injected type was not recorded";
+  ASSERT_NE(nullptr, inner) << "Construction of a type injected by a constructor was not recorded";
+  ASSERT_EQ(1UL, outer->count);
+  ASSERT_LE(inner->total, outer->total - outer->self) << "Nested construction was not excluded from self time";
+  ASSERT_NE(nullptr, find(autowiring::StartupPhase::ResolveSlots, "ProfiledOuter"));
+  ASSERT_NE(nullptr, find(autowiring::StartupPhase::StartRunnable, "ProfiledRunnable"));
+  ASSERT_NE(nullptr, find(autowiring::StartupPhase::NotifyBolts, "void"));
+
+  for (size_t i = 1; i < report.size(); i++)
+    ASSERT_GE(report[i - 1].self, report[i].self) << "Report was not sorted by self time";
+
+  std::stringstream os;
+  profiler->WriteFoldedStacks(os);
+  ASSERT_NE(std::string::npos, os.str().find("construct ProfiledOuter;construct ProfiledInner "))
+    << "Nested phases were not written as a single stack";
+
+  std::stringstream table;
+  profiler->WriteReport(table);
+  ASSERT_NE(std::string::npos, table.str().find("construct ProfiledOuter in void")) << "Report table was missing an entry";
+
+  ctxt->SignalShutdown(true);
+}
+
+namespace {
+  // Queries the context from every call, which deadlocks if called with the context's lock held
+  class ReentrantProfiler:
+    public autowiring::ContextProfiler
+  {
+  public:
+    std::vector<const CoreContext*> entered;
+    size_t nResolveSlots = 0;
+
+    void Enter(const CoreContext& ctxt, autowiring::StartupPhase phase, auto_id) override {
+      ctxt.GetRunnables();
+      entered.push_back(&ctxt);
+      if (phase == autowiring::StartupPhase::ResolveSlots)
+        nResolveSlots++;
+    }
+
+    void Leave(void) override {
+      entered.back()->GetRunnables();
+      entered.pop_back();
+    }
+  };
+}
+
+TEST_F(AutowiringDebugTest, ProfilerMayQueryContext) {
+  AutoCreateContext ctxt;
+  auto profiler = std::make_shared<ReentrantProfiler>();
+  ctxt->SetProfiler(profiler);
+
+  ctxt->Inject<ProfiledOuter>();
+  ASSERT_NE(0UL, profiler->nResolveSlots) << "Slot resolution was not reported";
+  ASSERT_TRUE(profiler->entered.empty()) << "A phase was entered but never left";
+}
@@ -0,0 +1,114 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/BatchedAutoFilter.h>
+#include <condition_variable>
+
+class BatchedAutoFilterTest:
+  public testing::Test
+{
+public:
+  BatchedAutoFilterTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+};
+
+namespace {
+  class SumsBatches:
+    public BatchedAutoFilter<int>
+  {
+  public:
+    SumsBatches(size_t batchSize, std::chrono::microseconds latency) :
+      BatchedAutoFilter<int>(batchSize, latency)
+    {}
+
+    std::mutex lock;
+    std::condition_variable cv;
+    std::vector<size_t> sizes;
+    std::vector<int> values;
+
+    void AutoFilterBatch(const autowiring::batch<int>& batch) override {
+      std::lock_guard<std::mutex> lk(lock);
+      sizes.push_back(batch.size());
+      for (size_t i = 0; i < batch.size(); i++) {
+        values.push_back(batch[i]);
+        batch.packet(i).Decorate(std::to_string(batch[i]));
+      }
+      cv.notify_all();
+    }
+
+    bool WaitForValues(size_t n) {
+      std::unique_lock<std::mutex> lk(lock);
+      return cv.wait_for(lk, std::chrono::seconds(5), [&] { return values.size() >= n; });
+    }
+  };
+
+  class BigBatches:
+    public SumsBatches
+  {
+  public:
+    BigBatches(void) : SumsBatches(4, std::chrono::seconds(60)) {}
+  };
+
+  class SlowBatches:
+    public SumsBatches
+  {
+  public:
+    SlowBatches(void) : SumsBatches(1000, std::chrono::milliseconds(1)) {}
+  };
+}
+
+TEST_F(BatchedAutoFilterTest, BatchSizeTriggersCall) {
+  AutoRequired<AutoPacketFactory> factory;
+  AutoRequired<BigBatches> filter;
+
+  for (int i = 0; i < 8; i++)
+    factory->NewPacket()->Decorate(i);
+
+  ASSERT_TRUE(filter->WaitForValues(8)) << "Full batches were not processed";
+  ASSERT_EQ(2UL, filter->sizes.size()) << "Batches were not collected up to the requested size";
+  ASSERT_EQ(4UL, filter->sizes[0]);
+  ASSERT_EQ(4UL, filter->sizes[1]);
+  for (int i = 0; i < 8; i++)
+    ASSERT_EQ(i, filter->values[i]) << "Batch entries were delivered out of order";
+}
+
+TEST_F(BatchedAutoFilterTest, LatencyTriggersCall) {
+  AutoRequired<AutoPacketFactory> factory;
+  AutoRequired<SlowBatches> filter;
+
+  for (int i = 0; i < 3; i++)
+    factory->NewPacket()->Decorate(i);
+
+  ASSERT_TRUE(filter->WaitForValues(3)) << "Partial batch was not processed when its latency budget expired";
+  ASSERT_EQ(3UL, filter->values.size());
+}
+
+TEST_F(BatchedAutoFilterTest, BatchCanDecoratePackets) {
+  AutoRequired<AutoPacketFactory> factory;
+  AutoRequired<BigBatches> filter;
+
+  std::mutex lock;
+  std::vector<std::string> received;
+  *factory += [&](const std::string& value) {
+    std::lock_guard<std::mutex> lk(lock);
+    received.push_back(value);
+  };
+
+  for (int i = 0; i < 4; i++)
+    factory->NewPacket()->Decorate(i);
+
+  ASSERT_TRUE(filter->WaitForValues(4));
+  std::lock_guard<std::mutex> lk(lock);
+  ASSERT_EQ(4UL, received.size()) << "Downstream filters were not called on outputs attached by a batch";
+  ASSERT_EQ("0", received[0]);
+  ASSERT_EQ("3", received[3]);
+}
+
+TEST_F(BatchedAutoFilterTest, UnsatisfiableNotCollected) {
+  AutoRequired<AutoPacketFactory> factory;
+  AutoRequired<BigBatches> filter;
+
+  factory->NewPacket()->MarkUnsatisfiable<int>();
+  filter->Flush();
+  ASSERT_TRUE(filter->sizes.empty()) << "A packet without the batched decoration was collected";
+}
@@ -251,3 +251,20 @@ TEST_F(BoltTest, PrePopulateBolt) {
   ASSERT_TRUE(l->hit) << "Bolt was not hit after contexts were created, even though those contexts still exist";
   ASSERT_EQ(3U, l->hitCount) << "Bolt did not traverse the expected number of child contexts";
 }
+
+TEST_F(BoltTest, PrePopulateBoltPastUnmatched) {
+  AutoCurrentContext ctxt;
+
+  // Matching contexts are interleaved with contexts the bolt is not interested in
+  auto o1 = ctxt->Create<OtherContext>();
+  auto p1 = ctxt->Create<Pipeline>();
+  auto o2 = ctxt->Create<OtherContext>();
+  auto p21 = o2->Create<Pipeline>();
+
+  AutoRequired<Listener> l;
+  ASSERT_EQ(2U, l->hitCount) << "Bolt traversal stopped at a context whose sigil did not match";
+
+  TargetBoltable<Pipeline>::InitializeNum();
+  AutoEnable<TargetBoltable<Pipeline>>();
+  ASSERT_EQ(2, TargetBoltable<Pipeline>::ConstructedNum()) << "Boltable was not injected into every existing matching context";
+}
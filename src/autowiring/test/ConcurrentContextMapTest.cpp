@@ -0,0 +1,134 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/autowiring.h>
+#include <autowiring/ConcurrentContextMap.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include THREAD_HEADER
+
+class ConcurrentContextMapTest:
+  public testing::Test
+{};
+
+TEST_F(ConcurrentContextMapTest, VerifySimple) {
+  ConcurrentContextMap<std::string> mp;
+  std::weak_ptr<CoreContext> ctxtWeak;
+
+  {
+    AutoCreateContext context;
+    ctxtWeak = context;
+    mp.Add("context_simple", context);
+
+    ASSERT_EQ(1UL, mp.size()) << "Context map did not count its entry";
+    ASSERT_EQ(context, mp.Find("context_simple")) << "Context map did not return the context added to it";
+    ASSERT_EQ(nullptr, mp.Find("context_missing")) << "Context map returned a context for a key it does not hold";
+    ASSERT_ANY_THROW(mp.Add("context_simple", context)) << "A key held by a live context was reassigned";
+  }
+
+  ASSERT_TRUE(ctxtWeak.expired()) << "Context map held a reference to its context";
+  ASSERT_EQ(nullptr, mp.Find("context_simple")) << "Expired context was returned";
+  ASSERT_EQ(1UL, mp.size()) << "Expired entry was evicted before a sweep";
+
+  mp.Sweep();
+  ASSERT_EQ(0UL, mp.size()) << "Expired entry was not evicted by a sweep";
+}
+
+TEST_F(ConcurrentContextMapTest, ExpiredKeyIsReplaced) {
+  ConcurrentContextMap<int> mp;
+  mp.Add(1, AutoCreateContext());
+
+  AutoCreateContext context;
+  ASSERT_NO_THROW(mp.Add(1, context)) << "Key of an expired context could not be reused";
+  ASSERT_EQ(context, mp.Find(1));
+  ASSERT_EQ(1UL, mp.size()) << "Expired entry was not replaced";
+}
+
+TEST_F(ConcurrentContextMapTest, ManyEntries) {
+  ConcurrentContextMap<int> mp(4);
+  std::vector<std::shared_ptr<CoreContext>> contexts;
+
+  // Enough entries to grow every shard several times
+  for (int i = 0; i < 500; i++) {
+    contexts.push_back(AutoCreateContext());
+    mp.Add(i, contexts.back());
+  }
+  ASSERT_EQ(500UL, mp.size());
+  for (int i = 0; i < 500; i++)
+    ASSERT_EQ(contexts[i], mp.Find(i)) << "Entry " << i << " was lost";
+
+  // Release every other context, enumeration must only see the rest
+  for (int i = 0; i < 500; i += 2)
+    contexts[i].reset();
+
+  size_t nLive = 0;
+  mp.Enumerate([&](int key, const std::shared_ptr<CoreContext>& ctxt) {
+    EXPECT_EQ(1, key % 2) << "An expired entry was enumerated";
+    EXPECT_EQ(contexts[key], ctxt);
+    nLive++;
+    return true;
+  });
+  ASSERT_EQ(250UL, nLive);
+
+  mp.Sweep();
+  ASSERT_EQ(250UL, mp.size()) << "Sweep did not evict exactly the expired entries";
+
+  mp.clear();
+  ASSERT_EQ(0UL, mp.size());
+  ASSERT_EQ(nullptr, mp.Find(1));
+}
+
+TEST_F(ConcurrentContextMapTest, ConcurrentReadersAndWriters) {
+  ConcurrentContextMap<int> mp(2);
+  AutoCurrentContext ctxt;
+
+  // Keys below 100 are stable, the writer churns the keys above them
+  std::vector<std::shared_ptr<CoreContext>> stable;
+  for (int i = 0; i < 100; i++) {
+    stable.push_back(ctxt->Create<void>());
+    mp.Add(i, stable.back());
+  }
+
+  std::atomic<bool> proceed{true};
+  std::atomic<size_t> nMisses{0};
+  std::vector<std::thread> readers;
+  for (size_t t = 4; t--;)
+    readers.emplace_back([&] {
+      while (proceed)
+        for (int i = 0; i < 100; i++)
+          if (mp.Find(i) != stable[i])
+            nMisses++;
+    });
+
+  // Readers must be joined before anything here is asserted
+  size_t nLost = 0;
+  for (int i = 100; i < 2000; i++) {
+    auto churn = ctxt->Create<void>();
+    mp.Add(i, churn);
+    if (mp.Find(i) != churn)
+      nLost++;
+    if (i % 100 == 0)
+      mp.Sweep();
+  }
+
+  proceed = false;
+  for (auto& reader : readers)
+    reader.join();
+  ASSERT_EQ(0UL, nLost) << "A newly added entry could not be found";
+  ASSERT_EQ(0UL, nMisses) << "A reader failed to find a stable entry while the map was being modified";
+}
+
+TEST_F(ConcurrentContextMapTest, ExpiredEntriesAreSweptInBackground) {
+  ConcurrentContextMap<int> mp(1);
+  std::vector<std::shared_ptr<CoreContext>> contexts;
+  for (int i = 0; i < 100; i++) {
+    contexts.push_back(AutoCreateContext());
+    mp.Add(i, contexts.back());
+  }
+  contexts.clear();
+
+  // Nothing writes to the map again, so only a background sweep can evict the expired entries
+  for (size_t i = 0; i < 200 && mp.size(); i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  ASSERT_GT(8UL, mp.size()) << "Expired entries were not evicted without a later writer";
+}
@@ -231,3 +231,63 @@ TEST_F(ContextEnumeratorTest, ForwardIteratorCheck) {
   b++;
   ASSERT_EQ(a, b) << "std::advance did not actually advance an iterator";
 }
+
+TEST_F(ContextEnumeratorTest, SnapshotMatchesEnumerator) {
+  AutoCurrentContext ctxt;
+  std::vector<std::shared_ptr<CoreContext>> contexts;
+  for (size_t i = 4; i--;) {
+    auto parent = ctxt->Create<void>();
+    contexts.push_back(parent);
+    for (size_t j = 3; j--;)
+      contexts.push_back(parent->Create<NamedContext>());
+  }
+
+  std::vector<std::shared_ptr<CoreContext>> enumerated(ContextEnumerator(ctxt).begin(), ContextEnumerator(ctxt).end());
+  std::vector<std::shared_ptr<CoreContext>> visited;
+  ContextSnapshot snapshot(ctxt);
+  snapshot.Visit([&visited](const std::shared_ptr<CoreContext>& cur) { visited.push_back(cur); });
+  ASSERT_EQ(enumerated, visited) << "Snapshot did not visit the same contexts in the same order as an enumerator";
+  enumerated.clear();
+
+  // The snapshot is not affected by later changes to the tree
+  auto late = ctxt->Create<void>();
+  std::weak_ptr<CoreContext> released = contexts.back();
+  contexts.pop_back();
+  visited.pop_back();
+  ASSERT_TRUE(released.expired());
+
+  std::vector<std::shared_ptr<CoreContext>> revisited;
+  snapshot.Visit([&revisited](const std::shared_ptr<CoreContext>& cur) { revisited.push_back(cur); });
+  ASSERT_EQ(visited, revisited) << "Snapshot visited a destroyed context, or one created after it was taken";
+
+  // A fresh snapshot sees the changes
+  ASSERT_EQ(snapshot.size(), ContextSnapshot(ctxt).size()) << "Fresh snapshot did not reflect one creation and one destruction";
+}
+
+TEST_F(ContextEnumeratorTest, SnapshotParallelVisit) {
+  AutoCurrentContext ctxt;
+  std::vector<std::shared_ptr<CoreContext>> contexts;
+  for (size_t i = 20; i--;) {
+    contexts.push_back(ctxt->Create<void>());
+    auto parent = contexts.back();
+    for (size_t j = 5; j--;)
+      contexts.push_back(parent->Create<void>());
+  }
+
+  std::mutex lock;
+  std::unordered_set<CoreContext*> visited;
+  ContextSnapshot(ctxt).Visit(
+    [&](const std::shared_ptr<CoreContext>& cur) {
+      std::lock_guard<std::mutex> lk(lock);
+      ASSERT_TRUE(visited.insert(cur.get()).second) << "A context was visited more than once";
+    },
+    4
+  );
+  ASSERT_EQ(contexts.size() + 1, visited.size()) << "Parallel visit did not visit every context";
+
+  // Exceptions from any worker are delivered to the caller
+  ASSERT_THROW(
+    ContextSnapshot(ctxt).Visit([](const std::shared_ptr<CoreContext>&) { throw std::runtime_error("visit failed"); }, 4),
+    std::runtime_error
+  );
+}
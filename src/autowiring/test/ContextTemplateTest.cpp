@@ -0,0 +1,132 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/autowiring.h>
+#include <autowiring/ContextEnumerator.h>
+#include <autowiring/ContextTemplate.h>
+
+class ContextTemplateTest:
+  public testing::Test
+{};
+
+namespace {
+  struct RequestSigil {};
+
+  class RequestState {
+  public:
+    int status = 0;
+  };
+
+  class RequestHandler:
+    public ContextMember
+  {
+  public:
+    Autowired<RequestState> state;
+  };
+}
+
+TEST_F(ContextTemplateTest, StampsMembers) {
+  ContextTemplate<RequestSigil> requests;
+  requests.Add<RequestHandler>().Add<RequestState>();
+
+  auto ctxt = requests.Create();
+  ASSERT_TRUE(ctxt->Is<RequestSigil>()) << "Context was not created with the template's sigil";
+  ASSERT_EQ(AutoCurrentContext(), ctxt->GetParentContext());
+
+  std::shared_ptr<RequestHandler> handler;
+  std::shared_ptr<RequestState> state;
+  ctxt->FindByType(handler);
+  ctxt->FindByType(state);
+  ASSERT_TRUE(handler != nullptr) << "Member was not injected";
+  ASSERT_TRUE(state != nullptr) << "Member was not injected";
+  ASSERT_EQ(state.get(), handler->state.get()) << "Members of a stamped context were not autowired to each other";
+}
+
+TEST_F(ContextTemplateTest, IssuesEachContextOnce) {
+  ContextTemplate<RequestSigil> requests;
+  requests.Add<RequestHandler>().Add<RequestState>();
+
+  // Released contexts are destroyed rather than returned to the template
+  std::weak_ptr<CoreContext> weak = requests.Create();
+  ASSERT_TRUE(weak.expired()) << "Context was retained after it was released";
+  ASSERT_EQ(0UL, requests.GetReservedCount());
+
+  // The issued pointer is the context's own
+  auto ctxt = requests.Create();
+  auto self = ctxt->shared_from_this();
+  ASSERT_FALSE(ctxt.owner_before(self) || self.owner_before(ctxt)) << "Issued pointer does not share the context's control block";
+}
+
+TEST_F(ContextTemplateTest, Reserve) {
+  ContextTemplate<RequestSigil> requests;
+  requests.Add<RequestState>();
+  requests.Reserve(3);
+  ASSERT_EQ(3UL, requests.GetReservedCount());
+
+  auto ctxt = requests.Create();
+  ASSERT_EQ(2UL, requests.GetReservedCount()) << "Context was not taken from the reserve";
+  ASSERT_TRUE(ctxt->Inject<RequestState>() != nullptr);
+
+  // Adding a member invalidates reserved contexts
+  requests.Add<RequestHandler>();
+  ASSERT_EQ(0UL, requests.GetReservedCount()) << "Stale contexts were retained after a member was added";
+}
+
+TEST_F(ContextTemplateTest, ShutDownContextsAreNotIssued) {
+  AutoCreateContext parent;
+  ContextTemplate<RequestSigil> requests(parent);
+  requests.Add<RequestState>();
+  requests.Reserve(1);
+
+  // A reserved context shut down through the parent's enumerator is skipped
+  std::shared_ptr<CoreContext> shutDown;
+  for (auto child : ContextEnumeratorT<RequestSigil>(parent)) {
+    shutDown = child;
+    break;
+  }
+  ASSERT_TRUE(shutDown != nullptr) << "Reserved context was not a child of the parent";
+  shutDown->SignalShutdown();
+
+  auto ctxt = requests.Create();
+  ASSERT_NE(shutDown, ctxt) << "A shut down context was issued";
+  ASSERT_FALSE(ctxt->IsShutdown());
+  ctxt.reset();
+  ASSERT_EQ(0UL, requests.GetReservedCount()) << "Shut down context was left in the reserve";
+
+  // Shutting down the parent discards the reserve and stops further reservation
+  requests.Reserve(2);
+  ASSERT_EQ(2UL, requests.GetReservedCount());
+  parent->SignalShutdown();
+  ASSERT_EQ(0UL, requests.GetReservedCount()) << "Reserve was retained after the parent was shut down";
+  requests.Reserve(2);
+  ASSERT_EQ(0UL, requests.GetReservedCount()) << "Contexts were reserved after the parent was shut down";
+}
+
+namespace {
+  ContextTemplate<RequestSigil>* g_pAddDuringStamp = nullptr;
+
+  // Adds a member to the template while one of its contexts is being stamped
+  class AddsMemberWhenStamped {
+  public:
+    AddsMemberWhenStamped(void) {
+      if (auto pRequests = g_pAddDuringStamp) {
+        g_pAddDuringStamp = nullptr;
+        pRequests->Add<RequestHandler>();
+      }
+    }
+  };
+}
+
+TEST_F(ContextTemplateTest, ReserveDiscardsContextsMissingAddedMember) {
+  ContextTemplate<RequestSigil> requests;
+  requests.Add<RequestState>().Add<AddsMemberWhenStamped>();
+
+  g_pAddDuringStamp = &requests;
+  requests.Reserve(1);
+  ASSERT_EQ(nullptr, g_pAddDuringStamp) << "Member was not added during stamping";
+  ASSERT_EQ(1UL, requests.GetReservedCount());
+
+  auto ctxt = requests.Create();
+  std::shared_ptr<RequestHandler> handler;
+  ctxt->FindByType(handler);
+  ASSERT_TRUE(handler != nullptr) << "A context stamped before a member was added was reserved";
+}
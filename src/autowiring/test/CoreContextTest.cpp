@@ -715,3 +715,192 @@ TEST_F(CoreContextTest, AncestorCount) {
   ASSERT_EQ(ctxt->AncestorCount + 2, child2->AncestorCount);
   ASSERT_EQ(ctxt->AncestorCount + 3, child3->AncestorCount);
 }
+
+namespace {
+  class RelatedInterface {
+  public:
+    virtual ~RelatedInterface(void) {}
+  };
+
+  class UnrelatedInterface {
+  public:
+    virtual ~UnrelatedInterface(void) {}
+  };
+
+  class ImplementsRelated:
+    public CoreObject,
+    public RelatedInterface
+  {};
+}
+
+TEST_F(CoreContextTest, InterfaceResolutionAcrossContexts) {
+  // Relations between classes are shared by all contexts, every context must still resolve correctly
+  for (size_t i = 0; i < 3; i++) {
+    AutoCreateContext ctxt;
+    CurrentContextPusher pshr(ctxt);
+
+    Autowired<RelatedInterface> deferred;
+    Autowired<UnrelatedInterface> unrelated;
+    ASSERT_FALSE(deferred.IsAutowired());
+
+    AutoRequired<ImplementsRelated> obj;
+    ASSERT_TRUE(deferred.IsAutowired()) << "Deferred interface was not satisfied when an implementation was added";
+    ASSERT_EQ(static_cast<RelatedInterface*>(obj.get()), deferred.get());
+    ASSERT_FALSE(unrelated.IsAutowired()) << "Interface was satisfied by a class that does not implement it";
+
+    Autowired<RelatedInterface> resolved;
+    ASSERT_TRUE(resolved.IsAutowired()) << "Interface was not resolved against an existing implementation";
+    ASSERT_FALSE(Autowired<UnrelatedInterface>().IsAutowired());
+  }
+}
+
+namespace {
+  // Waits in OnStart until the specified number of instances have entered OnStart at the same time
+  class Rendezvous {
+  public:
+    Rendezvous(size_t n) : n(n) {}
+
+    bool Arrive(void) {
+      std::unique_lock<std::mutex> lk(lock);
+      arrived++;
+      cv.notify_all();
+      return cv.wait_for(lk, std::chrono::seconds(5), [this] { return arrived >= n; });
+    }
+
+  private:
+    const size_t n;
+    size_t arrived = 0;
+    std::mutex lock;
+    std::condition_variable cv;
+  };
+
+  template<int N>
+  class StartsConcurrently:
+    public CoreObject,
+    public CoreRunnable
+  {
+  public:
+    Autowired<Rendezvous> rendezvous;
+    bool concurrent = false;
+
+    bool OnStart(void) override {
+      concurrent = rendezvous->Arrive();
+      return true;
+    }
+  };
+
+  class StartsFirst:
+    public CoreObject,
+    public CoreRunnable
+  {
+  public:
+    // Set only once OnStart has finished, CoreRunnable::WasStarted is already true while OnStart runs
+    std::atomic<bool> finishedStarting{false};
+
+    bool OnStart(void) override {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      finishedStarting = true;
+      return true;
+    }
+  };
+
+  class StartsAfterDependency:
+    public CoreObject,
+    public CoreRunnable
+  {
+  public:
+    Autowired<StartsFirst> dependency;
+    bool dependencyStarted = false;
+
+    bool OnStart(void) override {
+      dependencyStarted = dependency->finishedStarting;
+      return true;
+    }
+  };
+}
+
+TEST_F(CoreContextTest, ParallelStartup) {
+  AutoCurrentContext()->Initiate();
+  AutoCreateContext ctxt;
+  ctxt->SetStartupConcurrency(4);
+  CurrentContextPusher pshr(ctxt);
+
+  ctxt->Inject<Rendezvous>(2);
+  AutoRequired<StartsConcurrently<0>> a;
+  AutoRequired<StartsConcurrently<1>> b;
+  AutoRequired<StartsAfterDependency> dependent;
+  AutoRequired<StartsFirst> dependency;
+
+  std::atomic<size_t> nStarted{0};
+  ctxt->runnableStarted += [&nStarted](const autowiring::CoreObjectDescriptor&, std::chrono::nanoseconds) { nStarted++; };
+
+  ctxt->Initiate();
+  ASSERT_TRUE(a->concurrent && b->concurrent) << "Independent runnables were not started concurrently";
+  ASSERT_TRUE(dependent->dependencyStarted) << "A runnable was started before a runnable it depends on";
+  ASSERT_EQ(4UL, nStarted) << "Startup time was not reported for every runnable";
+  ASSERT_TRUE(ctxt->IsRunning());
+
+  ctxt->SignalShutdown(true);
+}
+
+namespace {
+  // Waits in OnStop until another instance is also stopping
+  class StopsConcurrently:
+    public CoreObject,
+    public CoreRunnable
+  {
+  public:
+    StopsConcurrently(std::shared_ptr<Rendezvous> rendezvous) :
+      rendezvous(rendezvous)
+    {}
+
+    const std::shared_ptr<Rendezvous> rendezvous;
+    std::shared_ptr<bool> concurrent = std::make_shared<bool>(false);
+
+    bool OnStart(void) override { return true; }
+    void OnStop(bool) override { *concurrent = rendezvous->Arrive(); }
+  };
+}
+
+TEST_F(CoreContextTest, ParallelTeardown) {
+  AutoCurrentContext()->Initiate();
+  AutoCreateContext ctxt;
+  ctxt->SetTeardownConcurrency(4);
+  ctxt->Initiate();
+
+  auto rendezvous = std::make_shared<Rendezvous>(2);
+  std::mutex lock;
+  std::vector<std::string> order;
+  std::vector<std::shared_ptr<bool>> concurrent;
+  std::weak_ptr<CoreContext> weakChildren[2];
+
+  for (size_t i = 0; i < 2; i++) {
+    auto child = ctxt->Create<void>();
+    auto grandchild = child->Create<void>();
+    auto name = std::to_string(i);
+    child->onTeardown += [&lock, &order, name](const CoreContext&) {
+      std::lock_guard<std::mutex>{lock}, order.push_back("child" + name);
+    };
+    grandchild->onTeardown += [&lock, &order, name](const CoreContext&) {
+      std::lock_guard<std::mutex>{lock}, order.push_back("grandchild" + name);
+    };
+    child->Initiate();
+    grandchild->Initiate();
+    concurrent.push_back(child->Inject<StopsConcurrently>(rendezvous)->concurrent);
+    weakChildren[i] = child;
+  }
+
+  ctxt->SignalShutdown(true);
+  for (auto& flag : concurrent)
+    ASSERT_TRUE(*flag) << "Child contexts were not stopped concurrently";
+  for (auto& weak : weakChildren)
+    ASSERT_TRUE(weak.expired()) << "Child context was not released during shutdown";
+
+  ASSERT_EQ(4UL, order.size());
+  for (size_t i = 0; i < 2; i++) {
+    auto name = std::to_string(i);
+    auto child = std::find(order.begin(), order.end(), "child" + name);
+    auto grandchild = std::find(order.begin(), order.end(), "grandchild" + name);
+    ASSERT_TRUE(grandchild < child) << "A context was torn down before its child";
+  }
+}
@@ -0,0 +1,87 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/DecorationArena.h>
+#include <cstdint>
+
+using autowiring::DecorationArena;
+
+class DecorationArenaTest:
+  public testing::Test
+{
+public:
+  DecorationArenaTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+  AutoRequired<AutoPacketFactory> factory;
+};
+
+namespace {
+  struct alignas(64) OverAligned {
+    int value = 99;
+  };
+
+  struct CountsDestruction {
+    CountsDestruction(int& nDestroyed) : nDestroyed(nDestroyed) {}
+    ~CountsDestruction(void) { nDestroyed++; }
+    int& nDestroyed;
+  };
+}
+
+TEST_F(DecorationArenaTest, AlignmentIsRespected) {
+  auto* arena = new DecorationArena;
+  auto a = std::allocate_shared<char>(arena->get_allocator<char>(), 'a');
+  auto b = std::allocate_shared<OverAligned>(arena->get_allocator<OverAligned>());
+  auto c = std::allocate_shared<std::vector<char>>(arena->get_allocator<std::vector<char>>(), DecorationArena::PageSize);
+  arena->Release();
+
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(b.get()) % 64) << "Over-aligned decoration was not correctly aligned";
+  ASSERT_EQ(99, b->value);
+  ASSERT_EQ('a', *a);
+  ASSERT_EQ(DecorationArena::PageSize, c->size());
+}
+
+TEST_F(DecorationArenaTest, OversizedAllocation) {
+  auto* arena = new DecorationArena;
+  void* pSmall = arena->Allocate(16, 8);
+  void* pLarge = arena->Allocate(DecorationArena::PageSize * 4, 8);
+  void* pSmall2 = arena->Allocate(16, 8);
+  ASSERT_NE(nullptr, pLarge);
+  ASSERT_EQ(static_cast<char*>(pSmall) + 16, static_cast<char*>(pSmall2)) << "Oversized allocation disturbed the bump pointer";
+  ASSERT_LE(DecorationArena::PageSize * 5, arena->GetReservedBytes());
+
+  arena->Deallocate(pSmall);
+  arena->Deallocate(pLarge);
+  arena->Deallocate(pSmall2);
+  arena->Release();
+}
+
+TEST_F(DecorationArenaTest, DecorationOutlivesPacket) {
+  int nDestroyed = 0;
+  std::shared_ptr<const CountsDestruction> held;
+  {
+    auto packet = factory->NewPacket();
+    packet->Emplace<CountsDestruction>(nDestroyed);
+    packet->Decorate(std::string("hello world"));
+    held = *packet->GetShared<CountsDestruction>();
+  }
+
+  ASSERT_EQ(0, nDestroyed) << "Decoration was destroyed while a shared pointer to it was still held";
+  ASSERT_EQ(&nDestroyed, &held->nDestroyed);
+  held.reset();
+  ASSERT_EQ(1, nDestroyed) << "Decoration was not destroyed when the last reference was released";
+}
+
+TEST_F(DecorationArenaTest, AutoOutStillWorks) {
+  *factory += [](int value, std::string& out) {
+    out = std::to_string(value);
+  };
+
+  std::shared_ptr<const std::string> result;
+  *factory += [&result](std::shared_ptr<const std::string> in) {
+    result = in;
+  };
+
+  factory->NewPacket()->Decorate(42);
+  ASSERT_TRUE(result != nullptr) << "Downstream filter was not called";
+  ASSERT_EQ("42", *result);
+}
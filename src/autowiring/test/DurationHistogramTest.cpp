@@ -0,0 +1,76 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/duration_histogram.h>
+#include <thread>
+
+using autowiring::duration_histogram;
+
+class DurationHistogramTest:
+  public testing::Test
+{};
+
+TEST_F(DurationHistogramTest, BucketsAreMonotonic) {
+  size_t prior = 0;
+  for (uint64_t value = 1; value < (1ULL << 40); value = value * 3 / 2 + 1) {
+    size_t bucket = duration_histogram::bucket_of(value);
+    ASSERT_LE(prior, bucket) << "Bucket index decreased for value " << value;
+    ASSERT_LE(duration_histogram::bucket_floor(bucket), value) << "Bucket floor exceeds a value it holds";
+    ASSERT_GT(duration_histogram::bucket_floor(bucket + 1), value) << "Value was placed in a bucket that is too low";
+    prior = bucket;
+  }
+  ASSERT_EQ(duration_histogram::BucketCount - 1, duration_histogram::bucket_of(~0ULL));
+}
+
+TEST_F(DurationHistogramTest, PercentilesAreAccurate) {
+  duration_histogram histogram;
+  for (int i = 1; i <= 1000; i++)
+    histogram.record(std::chrono::microseconds(i));
+
+  auto snapshot = histogram.take();
+  ASSERT_EQ(1000ULL, snapshot.count);
+  ASSERT_EQ(1000000ULL, snapshot.max);
+
+  auto p50 = snapshot.percentile(0.5).count();
+  auto p99 = snapshot.percentile(0.99).count();
+  ASSERT_NEAR(500000.0, p50, 500000.0 * 0.125) << "Median was not within the histogram's precision";
+  ASSERT_NEAR(990000.0, p99, 990000.0 * 0.125) << "99th percentile was not within the histogram's precision";
+  ASSERT_EQ(500500LL, snapshot.mean().count());
+}
+
+TEST_F(DurationHistogramTest, TakeAndReset) {
+  duration_histogram histogram;
+  histogram.record(std::chrono::milliseconds(1));
+  histogram.record(std::chrono::milliseconds(2));
+
+  auto first = histogram.take(true);
+  ASSERT_EQ(2ULL, first.count);
+  ASSERT_EQ(0ULL, histogram.count()) << "Histogram was not reset when its snapshot was taken";
+
+  histogram.record(std::chrono::microseconds(1));
+  auto second = histogram.take();
+  ASSERT_EQ(1ULL, second.count);
+  ASSERT_EQ(1000ULL, second.max) << "Maximum was carried over a reset";
+}
+
+TEST_F(DurationHistogramTest, ConcurrentRecording) {
+  duration_histogram histogram;
+  std::vector<std::thread> threads;
+  uint64_t taken = 0;
+  for (int i = 0; i < 4; i++)
+    threads.emplace_back([&histogram] {
+      for (int j = 0; j < 10000; j++)
+        histogram.record(std::chrono::nanoseconds(j));
+    });
+  size_t nWrapped = 0;
+  for (int i = 0; i < 10; i++) {
+    taken += histogram.take(true).count;
+    if (histogram.count() > 40000)
+      nWrapped++;
+  }
+  for (auto& thread : threads)
+    thread.join();
+  taken += histogram.take(true).count;
+
+  ASSERT_EQ(0UL, nWrapped) << "A reset subtracted samples the running count did not yet include";
+  ASSERT_EQ(40000ULL, taken) << "Samples were lost or double-counted by concurrent resets";
+}
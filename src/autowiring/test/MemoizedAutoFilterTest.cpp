@@ -0,0 +1,96 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/MemoizedAutoFilter.h>
+#include <string>
+
+class MemoizedAutoFilterTest:
+  public testing::Test
+{
+public:
+  MemoizedAutoFilterTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+  AutoRequired<AutoPacketFactory> factory;
+};
+
+namespace {
+  struct Calibration {
+    int gain;
+    bool operator==(const Calibration& rhs) const { return gain == rhs.gain; }
+  };
+
+  class Scale {
+  public:
+    void AutoFilter(const Calibration& calibration, int value, std::string& out) {
+      nCalls++;
+      out = std::to_string(calibration.gain * value);
+    }
+    int nCalls = 0;
+  };
+
+  class SmallCache:
+    public MemoizedAutoFilter<Scale>
+  {
+  public:
+    SmallCache(void) : MemoizedAutoFilter<Scale>(2) {}
+  };
+}
+
+namespace autowiring {
+  template<>
+  struct memo_hash<Calibration> {
+    size_t operator()(const Calibration& calibration) const {
+      return std::hash<int>()(calibration.gain);
+    }
+  };
+}
+
+TEST_F(MemoizedAutoFilterTest, RepeatedInputsAreCached) {
+  AutoRequired<MemoizedAutoFilter<Scale>> scale;
+  std::string last;
+  *factory += [&last] (const std::string& out) { last = out; };
+
+  for (int i = 0; i < 3; i++) {
+    auto packet = factory->NewPacket();
+    packet->Decorate(Calibration{2});
+    packet->Decorate(21);
+    ASSERT_EQ("42", last) << "Cached output was not attached to the packet";
+  }
+  ASSERT_EQ(1, scale->nCalls) << "Filter was called for inputs that were already cached";
+
+  auto packet = factory->NewPacket();
+  packet->Decorate(Calibration{3});
+  packet->Decorate(21);
+  ASSERT_EQ("63", last);
+  ASSERT_EQ(2, scale->nCalls) << "Filter was not called for new inputs";
+
+  auto stats = scale->GetMemoStatistics();
+  ASSERT_EQ(auto_id_t<Scale>{}, stats.type);
+  ASSERT_EQ(2ULL, stats.hits);
+  ASSERT_EQ(2ULL, stats.misses);
+  ASSERT_EQ(2UL, stats.size);
+  ASSERT_DOUBLE_EQ(0.5, stats.hitRate());
+}
+
+TEST_F(MemoizedAutoFilterTest, LeastRecentlyUsedIsEvicted) {
+  AutoRequired<SmallCache> scale;
+  auto issue = [this] (int value) {
+    auto packet = factory->NewPacket();
+    packet->Decorate(Calibration{1});
+    packet->Decorate(value);
+  };
+
+  issue(1);
+  issue(2);
+  issue(1);
+  issue(3);
+  ASSERT_EQ(3, scale->nCalls);
+  ASSERT_EQ(1ULL, scale->GetMemoStatistics().evictions) << "Cache exceeded its capacity";
+
+  // Input 1 was used more recently than input 2, so 2 should be the one that was evicted
+  issue(1);
+  ASSERT_EQ(3, scale->nCalls) << "Recently used entry was evicted";
+  issue(2);
+  ASSERT_EQ(4, scale->nCalls) << "Least recently used entry was not evicted";
+  ASSERT_EQ(2UL, scale->GetMemoStatistics().size);
+}
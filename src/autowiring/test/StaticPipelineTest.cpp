@@ -0,0 +1,83 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include <autowiring/StaticPipeline.h>
+#include <string>
+#include <vector>
+
+using autowiring::detail::pipeline_list;
+
+class StaticPipelineTest:
+  public testing::Test
+{
+public:
+  StaticPipelineTest(void) {
+    AutoCurrentContext()->Initiate();
+  }
+};
+
+namespace {
+  struct Summary {
+    int value = 0;
+    long squared = 0;
+  };
+
+  class Parse {
+  public:
+    void AutoFilter(const std::string& in, int& out) {
+      out = std::stoi(in);
+      calls.push_back("Parse");
+    }
+    std::vector<std::string> calls;
+  };
+
+  class Square {
+  public:
+    void AutoFilter(int value, long& out) {
+      out = static_cast<long>(value) * value;
+    }
+  };
+
+  class Describe {
+  public:
+    void AutoFilter(const long& squared, const int& value, Summary& summary) {
+      summary.value = value;
+      summary.squared = squared;
+    }
+  };
+
+  // Filters are deliberately listed out of dependency order
+  typedef StaticPipeline<Describe, Square, Parse> ParsePipeline;
+
+  static_assert(std::is_same<ParsePipeline::schedule, pipeline_list<Parse, Square, Describe>>::value, "Filters were not scheduled in dependency order");
+  static_assert(std::is_same<ParsePipeline::sources, pipeline_list<std::string>>::value, "Unproduced inputs were not identified as sources");
+  static_assert(std::is_same<ParsePipeline::exported, pipeline_list<Summary>>::value, "Unconsumed outputs were not exported");
+  static_assert(std::is_same<ParsePipeline::internal, pipeline_list<long, int>>::value, "Intermediate decorations were not identified");
+}
+
+TEST_F(StaticPipelineTest, DirectCall) {
+  ParsePipeline pipeline;
+  Summary summary;
+  pipeline.AutoFilter("12", summary);
+
+  ASSERT_EQ(12, summary.value);
+  ASSERT_EQ(144L, summary.squared);
+  ASSERT_EQ(1UL, pipeline.GetFilter<Parse>().calls.size()) << "Filter was not called exactly once";
+}
+
+TEST_F(StaticPipelineTest, InteroperatesWithFactory) {
+  AutoRequired<AutoPacketFactory> factory;
+  AutoRequired<ParsePipeline> pipeline;
+
+  // Dynamic filters supply the pipeline's source and consume its output
+  *factory += [] (double raw, std::string& out) { out = std::to_string(static_cast<int>(raw)); };
+  long squared = 0;
+  *factory += [&squared] (const Summary& summary) { squared = summary.squared; };
+
+  auto packet = factory->NewPacket();
+  packet->Decorate(7.0);
+
+  ASSERT_EQ(49L, squared) << "Exported output was not delivered to a dynamic filter";
+  ASSERT_TRUE(packet->Has<Summary>());
+  ASSERT_FALSE(packet->Has<int>()) << "An intermediate decoration was attached to the packet";
+  ASSERT_FALSE(packet->Has<long>()) << "An intermediate decoration was attached to the packet";
+}
@@ -1,5 +1,6 @@
 // Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
 #include "stdafx.h"
+#include "AutoFilterBm.h"
 #include "Benchmark.h"
 #include "ContextSearchBm.h"
 #include "ContextTrackingBm.h"
@@ -44,10 +45,16 @@ static std::map<std::string, Entry> sc_commands = {
   MakeEntry("search", "Autowiring context search cost", &ContextSearchBm::Search),
   MakeEntry("cache", "Autowiring cache behavior", &ContextSearchBm::Cache),
   MakeEntry("fast", "Autowired versus AutowiredFast", &ContextSearchBm::Fast),
+  MakeEntry("populate", "Cost of adding members to a large context", &ContextSearchBm::Populate),
   MakeEntry("dispatch", "Dispatch queue execution rate", &DispatchQueueBm::Dispatch),
   MakeEntry("contextenum", "CoreContextEnumerator profiling", &ContextTrackingBm::ContextEnum),
   MakeEntry("contextmap", "ContextMap profiling", &ContextTrackingBm::ContextMap),
+  MakeEntry("requestscope", "Per-request child context lifecycle", &ContextTrackingBm::RequestScope),
+  MakeEntry("bolts", "Bolt dispatch on context creation", &ContextTrackingBm::Bolts),
+  MakeEntry("pushers", "Current context and packet pusher round trips", &ContextTrackingBm::Pushers),
   MakeEntry("objpool", "Object pool behaviors", &ObjectPoolBm::Allocation),
+  MakeEntry("filtercall", "AutoFilter per-call overhead", &AutoFilterBm::CallOverhead),
+  MakeEntry("staticpipe", "Static pipeline versus dynamic filters", &AutoFilterBm::StaticPipelines),
 };
 
 static Benchmark All(void) {
@@ -0,0 +1,186 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#include "stdafx.h"
+#include "AutoFilterBm.h"
+#include "Benchmark.h"
+#include <autowiring/autowiring.h>
+#include <autowiring/StaticPipeline.h>
+
+static const size_t n = 10000;
+
+template<int N>
+struct Input {
+  int value = N;
+};
+
+struct Filter1 {
+  void AutoFilter(const Input<0>& a) {
+    sum += a.value;
+  }
+  int sum = 0;
+};
+
+struct Filter4 {
+  void AutoFilter(const Input<0>& a, const Input<1>& b, std::shared_ptr<const Input<2>> c, const Input<3>& d) {
+    sum += a.value + b.value + c->value + d.value;
+  }
+  int sum = 0;
+};
+
+struct Filter8 {
+  void AutoFilter(
+    const Input<0>& a, const Input<1>& b, const Input<2>& c, const Input<3>& d,
+    const Input<4>& e, const Input<5>& f, std::shared_ptr<const Input<6>> g, const Input<7>& h
+  ) {
+    sum += a.value + b.value + c.value + d.value + e.value + f.value + g->value + h.value;
+  }
+  int sum = 0;
+};
+
+// Issues a packet carrying every input any of the filters above could need
+static std::shared_ptr<AutoPacket> MakePacket(AutoPacketFactory& factory) {
+  auto packet = factory.NewPacket();
+  packet->Decorate(Input<0>());
+  packet->Decorate(Input<1>());
+  packet->Decorate(Input<2>());
+  packet->Decorate(Input<3>());
+  packet->Decorate(Input<4>());
+  packet->Decorate(Input<5>());
+  packet->Decorate(Input<6>());
+  packet->Decorate(Input<7>());
+  return packet;
+}
+
+// Invokes the filter's extracted call directly, this is the work done each time the filter is satisfied
+template<class T>
+void profile_call(Stopwatch& sw) {
+  AutoCreateContext ctxt;
+  CurrentContextPusher pshr(ctxt);
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+
+  auto filter = std::make_shared<T>();
+  autowiring::AutoFilterDescriptor desc(filter);
+  auto packet = MakePacket(*factory);
+
+  sw.Start();
+  for (size_t i = n; i--;)
+    desc.GetCall()(desc.GetAutoFilter().ptr(), *packet);
+  sw.Stop(n);
+  ctxt->SignalShutdown();
+}
+
+// Reads each argument with its own Get call, as the extractor did before arguments were resolved together
+template<int N>
+void profile_get(Stopwatch& sw) {
+  AutoCreateContext ctxt;
+  CurrentContextPusher pshr(ctxt);
+  AutoRequired<AutoPacketFactory> factory;
+  ctxt->Initiate();
+
+  auto packet = MakePacket(*factory);
+  int sum = 0;
+
+  sw.Start();
+  for (size_t i = n; i--;) {
+    CurrentContextPusher callPshr(packet->GetContext());
+    sum += packet->Get<Input<0>>().value;
+    if (N >= 4)
+      sum +=
+        packet->Get<Input<1>>().value +
+        (*packet->GetShared<Input<2>>())->value +
+        packet->Get<Input<3>>().value;
+    if (N >= 8)
+      sum +=
+        packet->Get<Input<4>>().value +
+        packet->Get<Input<5>>().value +
+        (*packet->GetShared<Input<6>>())->value +
+        packet->Get<Input<7>>().value;
+  }
+  sw.Stop(n);
+  ctxt->SignalShutdown();
+}
+
+Benchmark AutoFilterBm::CallOverhead(void) {
+  // Packet factories do not start until all of their parent contexts have started
+  AutoGlobalContext()->Initiate();
+
+  return {
+    { "per_arg_1", &profile_get<1> },
+    { "call_1", &profile_call<Filter1> },
+    { "per_arg_4", &profile_get<4> },
+    { "call_4", &profile_call<Filter4> },
+    { "per_arg_8", &profile_get<8> },
+    { "call_8", &profile_call<Filter8> }
+  };
+}
+
+template<int N>
+struct Stage {
+  void AutoFilter(const Input<N>& in, Input<N + 1>& out) {
+    out.value = in.value + 1;
+  }
+};
+
+typedef StaticPipeline<Stage<0>, Stage<1>, Stage<2>, Stage<3>> FourStages;
+
+// Four chained stages registered as ordinary filters
+static void profile_dynamic(Stopwatch& sw) {
+  AutoCreateContext ctxt;
+  CurrentContextPusher pshr(ctxt);
+  AutoRequired<AutoPacketFactory> factory;
+  AutoRequired<Stage<0>>();
+  AutoRequired<Stage<1>>();
+  AutoRequired<Stage<2>>();
+  AutoRequired<Stage<3>>();
+  ctxt->Initiate();
+
+  sw.Start();
+  for (size_t i = n; i--;)
+    factory->NewPacket()->Decorate(Input<0>());
+  sw.Stop(n);
+  ctxt->SignalShutdown();
+}
+
+// The same stages as a single static pipeline on a packet
+static void profile_static_packet(Stopwatch& sw) {
+  AutoCreateContext ctxt;
+  CurrentContextPusher pshr(ctxt);
+  AutoRequired<AutoPacketFactory> factory;
+  AutoRequired<FourStages>();
+  ctxt->Initiate();
+
+  sw.Start();
+  for (size_t i = n; i--;)
+    factory->NewPacket()->Decorate(Input<0>());
+  sw.Stop(n);
+  ctxt->SignalShutdown();
+}
+
+// The static pipeline called without a packet
+static void profile_static_direct(Stopwatch& sw) {
+  FourStages pipeline;
+  Input<0> in;
+  Input<4> out;
+
+  // Volatile access keeps the compiler from folding the whole loop away
+  volatile int source = 0;
+  volatile int sink = 0;
+
+  sw.Start();
+  for (size_t i = n; i--;) {
+    in.value = source;
+    pipeline.AutoFilter(in, out);
+    sink = out.value;
+  }
+  sw.Stop(n);
+}
+
+Benchmark AutoFilterBm::StaticPipelines(void) {
+  AutoGlobalContext()->Initiate();
+
+  return {
+    { "dynamic", &profile_dynamic },
+    { "static_packet", &profile_static_packet },
+    { "static_direct", &profile_static_direct }
+  };
+}
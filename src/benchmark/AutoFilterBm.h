@@ -0,0 +1,10 @@
+// Copyright (C) 2012-2015 Leap Motion, Inc. All rights reserved.
+#pragma once
+
+struct Benchmark;
+
+class AutoFilterBm {
+public:
+  static Benchmark CallOverhead(void);
+  static Benchmark StaticPipelines(void);
+};
@@ -3,6 +3,7 @@
 #include "ContextSearchBm.h"
 #include "Benchmark.h"
 #include <algorithm>
+#include <thread>
 #include <unordered_map>
 
 Benchmark ContextSearchBm::Search(void) {
@@ -42,6 +43,24 @@ Benchmark ContextSearchBm::Search(void) {
           AutowiredFast<Foo>();
         sw.Stop(n);
       }
+    },
+    {
+      "Autowired<T>, 8 threads",
+      [](Stopwatch& sw) {
+        // Each thread resolves the same type in the same context at once
+        AutoCurrentContext ctxt;
+        std::vector<std::thread> threads;
+        sw.Start();
+        for (size_t t = 8; t--;)
+          threads.emplace_back([ctxt] {
+            CurrentContextPusher pshr(ctxt);
+            for (size_t i = n; i--;)
+              Autowired<Foo>();
+          });
+        for (auto& thread : threads)
+          thread.join();
+        sw.Stop(n);
+      }
     }
   };
 }
@@ -219,3 +238,50 @@ Benchmark ContextSearchBm::Fast(void) {
     }
   };
 }
+
+namespace {
+  static const int sc_nMembers = 200;
+
+  template<int N>
+  class Interface {
+  public:
+    virtual ~Interface(void) {}
+  };
+
+  // Each member implements its own interface and depends on the interface of the member added after it
+  template<int N>
+  class Member:
+    public CoreObject,
+    public Interface<N>
+  {
+    Autowired<Interface<(N + 1) % sc_nMembers>> next;
+  };
+
+  template<int N>
+  struct AddMembers {
+    static void Add(void) {
+      AddMembers<N - 1>::Add();
+      AutoRequired<Member<N - 1>>();
+    }
+  };
+
+  template<>
+  struct AddMembers<0> {
+    static void Add(void) {}
+  };
+}
+
+Benchmark ContextSearchBm::Populate(void) {
+  return Benchmark{
+    {
+      "Add member, interface dependency",
+      [](Stopwatch& sw) {
+        AutoCreateContext ctxt;
+        CurrentContextPusher pshr(ctxt);
+        sw.Start();
+        AddMembers<sc_nMembers>::Add();
+        sw.Stop(sc_nMembers);
+      }
+    }
+  };
+}
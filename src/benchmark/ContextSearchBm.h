@@ -8,4 +8,5 @@ public:
   static Benchmark Search(void);
   static Benchmark Cache(void);
   static Benchmark Fast(void);
+  static Benchmark Populate(void);
 };
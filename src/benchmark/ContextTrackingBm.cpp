@@ -2,7 +2,10 @@
 #include "stdafx.h"
 #include "ContextTrackingBm.h"
 #include "Benchmark.h"
+#include <autowiring/AutoCurrentPacketPusher.h>
+#include <autowiring/ConcurrentContextMap.h>
 #include <autowiring/ContextMap.h>
+#include <autowiring/ContextTemplate.h>
 #include <functional>
 #include <thread>
 
@@ -63,6 +66,71 @@ Benchmark ContextTrackingBm::ContextEnum(void) {
     {
       "parallel x10",
       do_parallel_enum<1>
+    },
+    {
+      "snapshot",
+      [](Stopwatch& sw) {
+        AutoCurrentContext ctxt;
+        auto all = create();
+
+        // Every snapshot after the first reuses the copied child list
+        sw.Start();
+        ContextSnapshot(ctxt).Visit([](const std::shared_ptr<CoreContext>&) {});
+        sw.Stop(n);
+      }
+    },
+    {
+      "snapshot, parallel visit",
+      [](Stopwatch& sw) {
+        AutoCurrentContext ctxt;
+        auto all = create();
+
+        sw.Start();
+        ContextSnapshot(ctxt).Visit([](const std::shared_ptr<CoreContext>&) {}, 4);
+        sw.Stop(n);
+      }
+    },
+    {
+      "creation during snapshots",
+      [](Stopwatch& sw) {
+        // Contexts are created while another thread repeatedly snapshots their parent
+        AutoCurrentContext ctxt;
+        auto all = create();
+        auto proceed = std::make_shared<bool>(true);
+        std::thread snapshots([proceed, ctxt] {
+          while (*proceed)
+            ContextSnapshot(ctxt).Visit([](const std::shared_ptr<CoreContext>&) {});
+        });
+
+        sw.Start();
+        for (size_t i = n; i--;)
+          AutoCreateContext();
+        sw.Stop(n);
+
+        *proceed = false;
+        snapshots.join();
+      }
+    },
+    {
+      "creation during enumeration",
+      [](Stopwatch& sw) {
+        AutoCurrentContext ctxt;
+        auto all = create();
+        auto proceed = std::make_shared<bool>(true);
+        std::thread enumeration([proceed, ctxt] {
+          while (*proceed)
+            for (auto cur : ContextEnumerator(ctxt))
+              ;
+        });
+
+        sw.Start();
+        for (size_t i = n; i--;)
+          AutoCreateContext();
+        sw.Stop(n);
+
+        *proceed = false;
+        enumeration.join();
+      }
     }
   };
 }
@@ -94,6 +162,29 @@ static void do_parallel_map(Stopwatch& sw) {
   sw.Stop(n);
 }
 
+template<class Map, size_t N>
+static void do_concurrent_find(Stopwatch& sw) {
+  // Readers route by key to the contexts in the map, as a dispatcher would
+  auto all = create();
+  Map mp;
+  for (size_t i = 0; i < all.size(); i++)
+    mp.Add(i, all[i]);
+
+  std::vector<std::thread> threads;
+  sw.Start();
+  for (size_t t = N; t--;)
+    threads.emplace_back([&mp, &all] {
+      for (size_t round = 100; round--;)
+        for (size_t i = 0; i < all.size(); i++)
+          mp.Find(i);
+    });
+  for (auto& thread : threads)
+    thread.join();
+
+  // Reported per call to Find
+  sw.Stop(N * 100 * all.size());
+}
+
 Benchmark ContextTrackingBm::ContextMap(void) {
   static const size_t n = 100;
 
@@ -121,7 +212,250 @@ Benchmark ContextTrackingBm::ContextMap(void) {
     {
       "parallel x10",
       do_parallel_map<10>
+    },
+    {
+      "Find, 8 threads",
+      do_concurrent_find<::ContextMap<size_t>, 8>
+    },
+    {
+      "concurrent Find, 8 threads",
+      do_concurrent_find<ConcurrentContextMap<size_t>, 8>
+    }
+  };
+
+}
+
+namespace {
+  struct RequestSigil {};
+
+  class RequestState {
+  public:
+    int status = 0;
+  };
+
+  class RequestParser:
+    public ContextMember
+  {
+  public:
+    Autowired<RequestState> state;
+  };
+
+  class RequestHandler:
+    public ContextMember
+  {
+  public:
+    Autowired<RequestParser> parser;
+    Autowired<RequestState> state;
+  };
+
+  void PopulateRequest(CoreContext& ctxt) {
+    ctxt.Inject<RequestHandler>();
+    ctxt.Inject<RequestParser>();
+    ctxt.Inject<RequestState>();
+  }
+}
+
+Benchmark ContextTrackingBm::RequestScope(void) {
+  return {
+    {
+      "Create<Sigil>()",
+      [](Stopwatch& sw) {
+        AutoCurrentContext ctxt;
+        sw.Start();
+        for (size_t i = n; i--;)
+          ctxt->Create<RequestSigil>();
+        sw.Stop(n);
+      }
+    },
+    {
+      "Create<Sigil>(), 3 members",
+      [](Stopwatch& sw) {
+        AutoCurrentContext ctxt;
+        sw.Start();
+        for (size_t i = n; i--;)
+          PopulateRequest(*ctxt->Create<RequestSigil>());
+        sw.Stop(n);
+      }
+    },
+    {
+      "Create<Sigil>(), 3 members, run",
+      [](Stopwatch& sw) {
+        AutoCurrentContext ctxt;
+        sw.Start();
+        for (size_t i = n; i--;) {
+          auto request = ctxt->Create<RequestSigil>();
+          PopulateRequest(*request);
+          request->Initiate();
+          request->SignalShutdown();
+        }
+        sw.Stop(n);
+      }
+    },
+    {
+      "ContextTemplate, stamped",
+      [](Stopwatch& sw) {
+        ContextTemplate<RequestSigil> requests;
+        requests.Add<RequestHandler>().Add<RequestParser>().Add<RequestState>();
+        sw.Start();
+        for (size_t i = n; i--;)
+          requests.Create();
+        sw.Stop(n);
+      }
+    },
+    {
+      "ContextTemplate, Reserve",
+      [](Stopwatch& sw) {
+        ContextTemplate<RequestSigil> requests;
+        requests.Add<RequestHandler>().Add<RequestParser>().Add<RequestState>();
+        sw.Start();
+        requests.Reserve(n);
+        sw.Stop(n);
+      }
+    },
+    {
+      "ContextTemplate, Create from reserve",
+      [](Stopwatch& sw) {
+        // Stamping is timed separately by the Reserve entry, this is only the cost on the issuing thread
+        ContextTemplate<RequestSigil> requests;
+        requests.Add<RequestHandler>().Add<RequestParser>().Add<RequestState>();
+        requests.Reserve(n);
+        sw.Start();
+        for (size_t i = n; i--;)
+          requests.Create();
+        sw.Stop(n);
+      }
     }
   };
+}
+
+namespace {
+  template<int N>
+  struct OtherSigil {};
+
+  template<int N>
+  class OtherListener:
+    public Bolt<OtherSigil<N>>
+  {
+  public:
+    void ContextCreated(void) override {}
+  };
+
+  class RequestListener:
+    public Bolt<RequestSigil>
+  {
+  public:
+    size_t nCreated = 0;
+    void ContextCreated(void) override { nCreated++; }
+  };
+
+  class RequestScoped:
+    public Boltable<RequestSigil>
+  {};
+
+  template<int... Ns>
+  void AddOtherListeners(CoreContext& ctxt) {
+    autowiring::noop((ctxt.Inject<OtherListener<Ns>>(), false)...);
+  }
+}
 
+Benchmark ContextTrackingBm::Bolts(void) {
+  return {
+    {
+      "Create<Sigil>(), 1 bolt",
+      [](Stopwatch& sw) {
+        AutoCreateContext ctxt;
+        ctxt->Inject<RequestListener>();
+        sw.Start();
+        for (size_t i = n; i--;)
+          ctxt->Create<RequestSigil>();
+        sw.Stop(n);
+      }
+    },
+    {
+      "Create<Sigil>(), 1 bolt, 16 unrelated",
+      [](Stopwatch& sw) {
+        AutoCreateContext ctxt;
+        ctxt->Inject<RequestListener>();
+        AddOtherListeners<0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15>(*ctxt);
+        sw.Start();
+        for (size_t i = n; i--;)
+          ctxt->Create<RequestSigil>();
+        sw.Stop(n);
+      }
+    },
+    {
+      "Create<Sigil>(), 8 levels without bolts",
+      [](Stopwatch& sw) {
+        std::shared_ptr<CoreContext> ctxt = AutoCreateContext();
+        for (size_t i = 8; i--;)
+          ctxt = ctxt->Create<void>();
+        sw.Start();
+        for (size_t i = n; i--;)
+          ctxt->Create<RequestSigil>();
+        sw.Stop(n);
+      }
+    },
+    {
+      "Bolt added after 100 contexts",
+      [](Stopwatch& sw) {
+        AutoCreateContext ctxt;
+        std::vector<std::shared_ptr<CoreContext>> children;
+        for (size_t i = 0; i < n; i += 2) {
+          children.push_back(ctxt->Create<OtherSigil<0>>());
+          children.push_back(ctxt->Create<RequestSigil>());
+        }
+
+        sw.Start();
+        ctxt->Enable<RequestScoped>();
+        ctxt->Inject<RequestListener>();
+        sw.Stop(n);
+      }
+    }
+  };
+}
+
+Benchmark ContextTrackingBm::Pushers(void) {
+  static const size_t nRoundTrips = 1000;
+
+  return {
+    {
+      "CurrentContext()",
+      [](Stopwatch& sw) {
+        AutoCreateContext ctxt;
+        CurrentContextPusher pshr(ctxt);
+        sw.Start();
+        for (size_t i = nRoundTrips; i--;)
+          CoreContext::CurrentContext();
+        sw.Stop(nRoundTrips);
+      }
+    },
+    {
+      "CurrentContextPusher",
+      [](Stopwatch& sw) {
+        AutoCreateContext ctxt;
+        sw.Start();
+        for (size_t i = nRoundTrips; i--;)
+          CurrentContextPusher pshr(ctxt);
+        sw.Stop(nRoundTrips);
+      }
+    },
+    {
+      "AutoCurrentPacketPusher",
+      [](Stopwatch& sw) {
+        // Packet factories do not start until all of their parent contexts have started
+        AutoGlobalContext()->Initiate();
+        AutoCreateContext ctxt;
+        CurrentContextPusher pshr(ctxt);
+        AutoRequired<AutoPacketFactory> factory;
+        ctxt->Initiate();
+
+        auto packet = factory->NewPacket();
+        sw.Start();
+        for (size_t i = nRoundTrips; i--;)
+          autowiring::AutoCurrentPacketPusher apkt(*packet);
+        sw.Stop(nRoundTrips);
+        ctxt->SignalShutdown();
+      }
+    }
+  };
 }
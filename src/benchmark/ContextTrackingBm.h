@@ -7,4 +7,7 @@ class ContextTrackingBm {
 public:
   static Benchmark ContextEnum(void);
   static Benchmark ContextMap(void);
+  static Benchmark RequestScope(void);
+  static Benchmark Bolts(void);
+  static Benchmark Pushers(void);
 };